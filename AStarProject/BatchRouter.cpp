@@ -0,0 +1,562 @@
+// ----------------------------------------------------------------
+//  BatchRouter: loads a graph once, then reads "start goal" pairs
+//  from a file or standard input and writes one line per query as
+//  each one finishes:
+//
+//      query-number start goal status cost [path...]
+//
+//  Queries run on a pool of threads with a bounded number in flight,
+//  so memory stays flat however many queries are streamed through.
+//  A throughput and latency summary goes to standard error at the end.
+//
+//  On machines with several memory nodes, --numa gives every node its
+//  own copy of the compressed graph and its own workers.
+//
+//  --artifacts keeps the graph's preprocessing in a file, which is
+//  reused on later runs for as long as the graph is unchanged.
+//
+//  --open buckets searches with a bucket open list in place of the
+//  heap.
+//
+//  The benchmarks and checks of the search code live in SearchChecks.
+// ----------------------------------------------------------------
+#define GRAPH_NO_SFML
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#include "Graph.h"
+#include "GraphIO.h"
+#include "CompressedGraph.h"
+#include "QueryExecutor.h"
+#include "NumaReplica.h"
+#include "SearchArtifacts.h"
+#include "RouteCache.h"
+#include "LatencyHistogram.h"
+
+using namespace std;
+
+typedef Graph<pair<string, int>, int> MapGraph;
+typedef chrono::steady_clock Clock;
+
+// ----------------------------------------------------------------
+//  Name:           Options
+//  Description:    Command line settings.
+// ----------------------------------------------------------------
+struct Options {
+	string nodesFile;
+	string arcsFile;
+	string binaryFile;
+	string saveFile;
+	string queriesFile;
+	string artifactsFile;
+	string ordering;
+	string openList;
+	bool fileWeights;
+	bool paths;
+	bool compressed;
+	bool numa;
+	bool hugePages;
+	int threads;
+	int window;
+	int timeoutMs;
+	int maxExpansions;
+	size_t cacheBytes;
+
+	Options() : nodesFile( "Nodes.txt" ), arcsFile( "Arcs.txt" ), openList( "heap" ), fileWeights( false ), paths( false ),
+		compressed( false ), numa( false ), hugePages( false ), threads( 0 ), window( 256 ), timeoutMs( 0 ), maxExpansions( 0 ), cacheBytes( 0 ) {
+	}
+};
+
+// ----------------------------------------------------------------
+//  Name:           Report
+//  Description:    Writes results and keeps the totals. Workers call
+//                  it as their queries finish.
+// ----------------------------------------------------------------
+class Report {
+private:
+	mutex m_lock;
+	const MapGraph& m_graph;
+	bool m_paths;
+	LatencyHistogram m_latency;
+	unsigned long long m_counts[5];
+	unsigned long long m_invalid;
+
+public:
+	Report( const MapGraph& graph, bool paths ) : m_graph( graph ), m_paths( paths ), m_invalid( 0 ) {
+		memset( m_counts, 0, sizeof( m_counts ) );
+	}
+
+	void result( long long query, int start, int goal, QueryStatus status, int cost, const vector<int>& path, Clock::time_point submitted ) {
+		static const char* names[5] = { "found", "no-path", "timed-out", "over-budget", "cancelled" };
+		double micros = chrono::duration<double, micro>( Clock::now() - submitted ).count();
+
+		lock_guard<mutex> guard( m_lock );
+		m_latency.add( micros );
+		m_counts[status]++;
+		cout << query << ' ' << start << ' ' << goal << ' ' << names[status] << ' ';
+		if( status == QUERY_FOUND ) {
+			cout << cost;
+		}
+		else {
+			cout << '-';
+		}
+		if( m_paths == true ) {
+			for( size_t i = 0; i < path.size(); i++ ) {
+				cout << ' ' << m_graph.externalIndex( path[i] );
+			}
+		}
+		cout << '\n';
+	}
+
+	void invalid( long long query, int start, int goal ) {
+		lock_guard<mutex> guard( m_lock );
+		m_invalid++;
+		cout << query << ' ' << start << ' ' << goal << " invalid -\n";
+	}
+
+	void summary( double seconds, RouteCache<int>* pCache ) {
+		lock_guard<mutex> guard( m_lock );
+		unsigned long long total = m_invalid;
+		for( int i = 0; i < 5; i++ ) {
+			total += m_counts[i];
+		}
+		cerr << "queries " << total << ", found " << m_counts[QUERY_FOUND] << ", no path " << m_counts[QUERY_NO_PATH] <<
+			", timed out " << m_counts[QUERY_TIMED_OUT] << ", over budget " << m_counts[QUERY_OVER_BUDGET] <<
+			", cancelled " << m_counts[QUERY_CANCELLED] << ", invalid " << m_invalid << endl;
+		if( pCache != 0 ) {
+			cerr << "cache hits " << pCache->hits() << ", misses " << pCache->misses() << ", evictions " << pCache->evictions() << endl;
+		}
+		cerr << "elapsed " << seconds << " s, " << (seconds > 0 ? total / seconds : 0) << " queries/s" << endl;
+		cerr << "latency us: p50 " << m_latency.percentile( 0.5 ) << ", p90 " << m_latency.percentile( 0.9 ) <<
+			", p99 " << m_latency.percentile( 0.99 ) << ", max " << m_latency.maximum() << endl;
+	}
+};
+
+// ----------------------------------------------------------------
+//  Name:           workersPerNode
+//  Description:    Splits the worker threads between the memory
+//                  nodes in use.
+//  Arguments:      The first parameter holds the settings.
+//                  The second parameter is the number of nodes.
+//  Return Value:   The workers for each node.
+// ----------------------------------------------------------------
+int workersPerNode( const Options& options, int nodes ) {
+	int threads = options.threads;
+	if( threads <= 0 ) {
+		threads = (int)thread::hardware_concurrency();
+	}
+	return max( 1, threads / nodes );
+}
+
+// ----------------------------------------------------------------
+//  Name:           BucketSearch
+//  Description:    A graph's search with a bucket open list in place
+//                  of the heap, for QueryExecutor. The workers share
+//                  it, so each search borrows an engine from a spare
+//                  list and gives it back, and the engines' buckets
+//                  are reused from one search to the next.
+// ----------------------------------------------------------------
+template<class SearchGraph>
+class BucketSearch {
+private:
+	typedef SearchEngine<SearchGraph, int, BucketOpenList<int> > Engine;
+
+	const SearchGraph& m_graph;
+	mutable vector<Engine*> m_spare;
+	mutable mutex m_lock;
+
+	// not copyable.
+	BucketSearch( const BucketSearch& );
+	BucketSearch& operator=( const BucketSearch& );
+
+public:
+	BucketSearch( const SearchGraph& graph ) : m_graph( graph ) {
+	}
+
+	~BucketSearch() {
+		for( size_t i = 0; i < m_spare.size(); i++ ) {
+			delete m_spare[i];
+		}
+	}
+
+	QuerySummary<int> boundedSearch( int start, int goal, const QueryOptions& options, SearchState<int>& state ) const {
+		Engine* pEngine = 0;
+		{
+			lock_guard<mutex> guard( m_lock );
+			if( m_spare.size() > 0 ) {
+				pEngine = m_spare.back();
+				m_spare.pop_back();
+			}
+		}
+		if( pEngine == 0 ) {
+			pEngine = new Engine();
+		}
+		QuerySummary<int> summary = m_graph.boundedSearch( start, goal, options, state, *pEngine );
+		lock_guard<mutex> guard( m_lock );
+		m_spare.push_back( pEngine );
+		return summary;
+	}
+};
+
+// ----------------------------------------------------------------
+//  Name:           streamQueries
+//  Description:    Streams the queries through executors on the
+//                  graphs given, until the input runs out. Queries
+//                  are dealt out to the executors in turn.
+//  Arguments:      The first parameter is the graphs to search, one
+//                  per executor.
+//                  The second parameter is the memory node each
+//                  executor's workers are bound to, or -1 for none.
+//                  The third parameter is the loaded graph, for
+//                  checking and translating indices.
+//                  The fourth parameter is the query input.
+//                  The fifth parameter holds the settings.
+//                  The sixth parameter collects the results.
+//                  The seventh parameter is the route cache, or 0.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class SearchGraph>
+void streamQueries( const vector<const SearchGraph*>& searchGraphs, const vector<int>& nodes, const MapGraph& graph,
+	istream& input, const Options& options, Report& report, RouteCache<int>* pCache ) {
+	int count = (int)searchGraphs.size();
+	vector<QueryExecutor<SearchGraph, int>*> executors;
+	for( int i = 0; i < count; i++ ) {
+		executors.push_back( new QueryExecutor<SearchGraph, int>( *searchGraphs[i],
+			count > 1 ? workersPerNode( options, count ) : options.threads, max( 1, options.window / count ), nodes[i] ) );
+	}
+
+	vector<int> cached;
+	long long query = 0;
+	int start, goal;
+	while( input >> start >> goal ) {
+		if( start < 0 || goal < 0 || start >= graph.maxSize() || goal >= graph.maxSize() ||
+			graph.nodeArray()[graph.internalIndex( start )] == 0 || graph.nodeArray()[graph.internalIndex( goal )] == 0 ) {
+			report.invalid( query++, start, goal );
+			continue;
+		}
+		int from = graph.internalIndex( start );
+		int to = graph.internalIndex( goal );
+		Clock::time_point submitted = Clock::now();
+
+		int cost;
+		if( pCache != 0 && pCache->lookup( from, to, graph.version(), cost, cached ) == true ) {
+			report.result( query++, start, goal, QUERY_FOUND, cost, cached, submitted );
+			continue;
+		}
+
+		QueryOptions limits;
+		if( options.timeoutMs > 0 ) {
+			limits.setTimeout( chrono::milliseconds( options.timeoutMs ) );
+		}
+		limits.maxExpansions = options.maxExpansions;
+
+		unsigned int version = graph.version();
+		executors[query % count]->submit( from, to, [&report, pCache, query, start, goal, from, to, version, submitted]( const QueryResult<int>& result ) {
+			if( pCache != 0 && result.status == QUERY_FOUND ) {
+				pCache->store( from, to, version, result.cost, result.path );
+			}
+			report.result( query, start, goal, result.status, result.cost, result.path, submitted );
+		}, limits );
+		query++;
+	}
+	for( int i = 0; i < count; i++ ) {
+		executors[i]->wait();
+		delete executors[i];
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           route
+//  Description:    Streams the queries through executors on the
+//                  graphs given, searching with the open list asked
+//                  for.
+//  Arguments:      As for streamQueries.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class SearchGraph>
+void route( const vector<const SearchGraph*>& searchGraphs, const vector<int>& nodes, const MapGraph& graph,
+	istream& input, const Options& options, Report& report, RouteCache<int>* pCache ) {
+	if( options.openList != "buckets" ) {
+		streamQueries( searchGraphs, nodes, graph, input, options, report, pCache );
+		return;
+	}
+	vector<const BucketSearch<SearchGraph>*> searches;
+	for( size_t i = 0; i < searchGraphs.size(); i++ ) {
+		searches.push_back( new BucketSearch<SearchGraph>( *searchGraphs[i] ) );
+	}
+	streamQueries( searches, nodes, graph, input, options, report, pCache );
+	for( size_t i = 0; i < searches.size(); i++ ) {
+		delete searches[i];
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           route
+//  Description:    Streams the queries through one executor on one
+//                  graph.
+//  Arguments:      As above, with the single graph first.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class SearchGraph>
+void route( const SearchGraph& searchGraph, const MapGraph& graph, istream& input, const Options& options, Report& report, RouteCache<int>* pCache ) {
+	route( vector<const SearchGraph*>( 1, &searchGraph ), vector<int>( 1, -1 ), graph, input, options, report, pCache );
+}
+
+// ----------------------------------------------------------------
+//  Name:           prepare
+//  Description:    Loads the graph's connectivity index from an
+//                  artifact file, or builds it and writes the file if
+//                  the file is missing or was built from a different
+//                  graph.
+//  Arguments:      The first parameter is the graph.
+//                  The second parameter is the artifact file.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+void prepare( MapGraph& graph, const string& file ) {
+	static const char* problems[6] = { "unusable", "missing", "corrupt", "from an old version", "stale", "from a machine of the other byte order" };
+	Clock::time_point start = Clock::now();
+	unsigned long long hash = graphHash( graph );
+
+	SearchArtifacts artifacts;
+	ArtifactStatus status = artifacts.open( file, hash );
+	if( status == ARTIFACT_OK && artifacts.loadComponentLabels( graph ) == true ) {
+		cerr << "loaded search artifacts from " << file << " in " <<
+			chrono::duration<double>( Clock::now() - start ).count() << " s" << endl;
+		return;
+	}
+	artifacts.close();
+
+	cerr << "search artifacts in " << file << " are " << problems[status] << ", rebuilding" << endl;
+	graph.buildComponents();
+	ArtifactWriter writer;
+	writer.addComponentLabels( graph );
+	if( writer.save( file, hash ) == false ) {
+		cerr << "could not write " << file << endl;
+	}
+}
+
+void usage() {
+	cerr << "usage: BatchRouter [options] [queries-file]\n"
+		"  reads \"start goal\" pairs from queries-file, or standard input if none or \"-\"\n"
+		"  --nodes FILE         node file (default Nodes.txt)\n"
+		"  --arcs FILE          arc file (default Arcs.txt)\n"
+		"  --file-weights       use the arc file's weights instead of arc lengths\n"
+		"  --binary FILE        load a binary graph instead of the text files\n"
+		"  --save-binary FILE   save the loaded graph in the binary format\n"
+		"  --reorder ORDER      renumber nodes: hilbert, bfs or rcm\n"
+		"  --artifacts FILE     reuse the graph's preprocessing saved in FILE,\n"
+		"                       rebuilding it there when the graph has changed\n"
+		"  --compressed         search the compressed copy of the arcs\n"
+		"  --numa               copy the compressed graph to each memory node and\n"
+		"                       give each node its own workers\n"
+		"  --huge-pages         keep the compressed graph's copies in huge pages\n"
+		"  --open LIST          open list: heap (default) or buckets\n"
+		"  --threads N          worker threads (default: one per core)\n"
+		"  --window N           most queries in flight at once (default 256)\n"
+		"  --timeout-ms N       time limit per query, from when it is read\n"
+		"  --max-expansions N   node expansion limit per query\n"
+		"  --cache-mb N         cache routes in N megabytes\n"
+		"  --paths              print each route's nodes\n";
+}
+
+// ----------------------------------------------------------------
+//  Name:           parseArguments
+//  Description:    Reads the command line into the settings.
+//  Arguments:      The first and second parameters are main's.
+//                  The third parameter is filled in.
+//  Return Value:   false if the command line is wrong.
+// ----------------------------------------------------------------
+bool parseArguments( int argc, char* argv[], Options& options ) {
+	for( int i = 1; i < argc; i++ ) {
+		string flag = argv[i];
+		bool hasValue = i + 1 < argc;
+		if( flag == "--file-weights" ) {
+			options.fileWeights = true;
+		}
+		else if( flag == "--compressed" ) {
+			options.compressed = true;
+		}
+		else if( flag == "--numa" ) {
+			options.numa = true;
+		}
+		else if( flag == "--huge-pages" ) {
+			options.hugePages = true;
+		}
+		else if( flag == "--paths" ) {
+			options.paths = true;
+		}
+		else if( flag.compare( 0, 2, "--" ) != 0 ) {
+			options.queriesFile = flag;
+		}
+		else if( hasValue == false ) {
+			return false;
+		}
+		else {
+			string value = argv[++i];
+			if( flag == "--nodes" ) {
+				options.nodesFile = value;
+			}
+			else if( flag == "--arcs" ) {
+				options.arcsFile = value;
+			}
+			else if( flag == "--binary" ) {
+				options.binaryFile = value;
+			}
+			else if( flag == "--save-binary" ) {
+				options.saveFile = value;
+			}
+			else if( flag == "--artifacts" ) {
+				options.artifactsFile = value;
+			}
+			else if( flag == "--reorder" ) {
+				options.ordering = value;
+				if( value != "hilbert" && value != "bfs" && value != "rcm" ) {
+					return false;
+				}
+			}
+			else if( flag == "--open" ) {
+				options.openList = value;
+				if( value != "heap" && value != "buckets" ) {
+					return false;
+				}
+			}
+			else if( flag == "--threads" ) {
+				options.threads = atoi( value.c_str() );
+			}
+			else if( flag == "--window" ) {
+				options.window = atoi( value.c_str() );
+			}
+			else if( flag == "--timeout-ms" ) {
+				options.timeoutMs = atoi( value.c_str() );
+			}
+			else if( flag == "--max-expansions" ) {
+				options.maxExpansions = atoi( value.c_str() );
+			}
+			else if( flag == "--cache-mb" ) {
+				options.cacheBytes = (size_t)atoi( value.c_str() ) << 20;
+			}
+			else {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+int main( int argc, char* argv[] ) {
+	ios::sync_with_stdio( false );
+
+	Options options;
+	if( parseArguments( argc, argv, options ) == false ) {
+		usage();
+		return 2;
+	}
+	ifstream file;
+	if( options.queriesFile.empty() == false && options.queriesFile != "-" ) {
+		file.open( options.queriesFile.c_str() );
+		if( !file ) {
+			cerr << "could not read " << options.queriesFile << endl;
+			return 1;
+		}
+	}
+	istream& input = file.is_open() ? file : cin;
+
+	Clock::time_point loadStart = Clock::now();
+	MapGraph* pGraph;
+	if( options.binaryFile.empty() == false ) {
+		pGraph = loadBinaryGraph<int>( options.binaryFile );
+	}
+	else {
+		pGraph = loadTextGraph<int>( options.nodesFile, options.arcsFile, options.fileWeights );
+	}
+	if( pGraph == 0 ) {
+		cerr << "could not load the graph" << endl;
+		return 1;
+	}
+	if( options.saveFile.empty() == false && saveBinaryGraph( *pGraph, options.saveFile ) == false ) {
+		cerr << "could not write " << options.saveFile << endl;
+		return 1;
+	}
+
+	if( options.ordering == "hilbert" ) {
+		pGraph->reorder( MapGraph::HILBERT_ORDER );
+	}
+	else if( options.ordering == "bfs" ) {
+		pGraph->reorder( MapGraph::BFS_ORDER );
+	}
+	else if( options.ordering == "rcm" ) {
+		pGraph->reorder( MapGraph::RCM_ORDER );
+	}
+	if( options.artifactsFile.empty() == false ) {
+		prepare( *pGraph, options.artifactsFile );
+	}
+	else {
+		pGraph->buildComponents();
+	}
+
+	// the copies are of the compressed graph.
+	bool replicate = options.numa == true || options.hugePages == true;
+	if( replicate == true ) {
+		options.compressed = true;
+	}
+	CompressedGraph<int>* pPacked = 0;
+	NumaReplicas<int>* pReplicas = 0;
+	if( options.compressed == true ) {
+		pPacked = new CompressedGraph<int>();
+		pPacked->build( *pGraph );
+	}
+	if( replicate == true ) {
+		// huge pages alone need just the one copy.
+		pReplicas = new NumaReplicas<int>( *pPacked, options.hugePages, options.numa == true ? 0 : 1 );
+		cerr << "copied the graph to " << pReplicas->count() << " memory node(s):";
+		for( int i = 0; i < pReplicas->count(); i++ ) {
+			cerr << ' ' << pReplicas->nodeId( i ) << '=' << (pReplicas->hugePages( i ) == true ? "huge" : "normal");
+		}
+		cerr << " pages" << endl;
+
+		// the searches only use the placed copies.
+		delete pPacked;
+		pPacked = 0;
+	}
+	cerr << "loaded " << pGraph->size() << " nodes in " <<
+		chrono::duration<double>( Clock::now() - loadStart ).count() << " s" << endl;
+
+	RouteCache<int>* pCache = 0;
+	if( options.cacheBytes > 0 ) {
+		pCache = new RouteCache<int>( options.cacheBytes );
+	}
+
+	Report report( *pGraph, options.paths );
+	Clock::time_point runStart = Clock::now();
+	if( pReplicas != 0 ) {
+		vector<const CompressedGraph<int>*> copies;
+		vector<int> nodes;
+		for( int i = 0; i < pReplicas->count(); i++ ) {
+			copies.push_back( &pReplicas->replica( i ) );
+			nodes.push_back( options.numa == true ? pReplicas->nodeId( i ) : -1 );
+		}
+		route( copies, nodes, *pGraph, input, options, report, pCache );
+	}
+	else if( options.compressed == true ) {
+		route( *pPacked, *pGraph, input, options, report, pCache );
+	}
+	else {
+		route( *pGraph, *pGraph, input, options, report, pCache );
+	}
+	cout.flush();
+	report.summary( chrono::duration<double>( Clock::now() - runStart ).count(), pCache );
+
+	delete pCache;
+	delete pReplicas;
+	delete pPacked;
+	delete pGraph;
+	return 0;
+}
@@ -0,0 +1,366 @@
+#ifndef COMPRESSEDGRAPH_H
+#define COMPRESSEDGRAPH_H
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <functional>
+#include <cstring>
+#include <cmath>
+
+#include "Graph.h"
+
+// ----------------------------------------------------------------
+//  Name:           CompressedGraph
+//  Description:    Read-only copy of a graph's arcs packed into one
+//                  byte array, for graphs too big to keep as lists of
+//                  GraphArc. Each node's arcs are sorted by target
+//                  and stored as the gap from the previous target (the
+//                  first from the node itself, with its sign folded
+//                  into the low bit) in a variable-length integer of
+//                  7 bits a byte, so arcs to nearby indices take one
+//                  or two bytes. Weights take two bytes as an offset
+//                  from the smallest one when they are whole numbers
+//                  within 65535 of each other, and their full size
+//                  otherwise, so the copy is always exact. Searches
+//                  read the arcs straight from the bytes through an
+//                  ArcCursor. All of the arrays sit in one block, so a
+//                  copy can be placed in memory the caller chooses,
+//                  such as huge pages on a particular NUMA node.
+// ----------------------------------------------------------------
+template<class ArcType>
+class CompressedGraph {
+private:
+	// ----------------------------------------------------------------
+	//  Description:    The block holding the arrays, in this order:
+	//                  where each node's arcs start in the arc bytes
+	//                  (plus one past the end), the node positions for
+	//                  the A* estimate, then the arc bytes. The block
+	//                  is m_storage unless it was placed by the caller.
+	//                  The offsets are size_t, so the arc bytes can
+	//                  grow as large as the address space allows.
+	// ----------------------------------------------------------------
+	vector<unsigned char> m_storage;
+	const size_t* m_pOffsets;
+	const int* m_pX;
+	const int* m_pY;
+	const unsigned char* m_pBytes;
+	int m_size;
+	size_t m_byteCount;
+
+	bool m_narrowWeights;
+	ArcType m_minWeight;
+	int m_arcCount;
+
+	// copies must say where their arrays go.
+	CompressedGraph( const CompressedGraph& );
+	CompressedGraph& operator=( const CompressedGraph& );
+
+	void writeNumber( vector<unsigned char>& packed, unsigned int value ) {
+		while( value >= 0x80 ) {
+			packed.push_back( (unsigned char)(value | 0x80) );
+			value >>= 7;
+		}
+		packed.push_back( (unsigned char)value );
+	}
+
+	void writeWeight( vector<unsigned char>& packed, ArcType weight ) {
+		if( m_narrowWeights == true ) {
+			unsigned int offset = (unsigned int)(weight - m_minWeight);
+			packed.push_back( (unsigned char)(offset & 0xff) );
+			packed.push_back( (unsigned char)(offset >> 8) );
+		}
+		else {
+			size_t at = packed.size();
+			packed.resize( at + sizeof( ArcType ) );
+			memcpy( &packed[at], &weight, sizeof( ArcType ) );
+		}
+	}
+
+	// points the arrays into a block laid out as above.
+	void place( unsigned char* pBlock ) {
+		m_pOffsets = (const size_t*)pBlock;
+		m_pX = (const int*)(m_pOffsets + m_size + 1);
+		m_pY = m_pX + m_size;
+		m_pBytes = (const unsigned char*)(m_pY + m_size);
+	}
+
+public:
+	// ----------------------------------------------------------------
+	//  Name:           ArcCursor
+	//  Description:    Walks the arcs of one node, decoding as it goes.
+	//                  Call next() before reading the first arc.
+	// ----------------------------------------------------------------
+	class ArcCursor {
+	private:
+		const CompressedGraph* m_pGraph;
+		const unsigned char* m_pNext;
+		const unsigned char* m_pEnd;
+		int m_node;
+		bool m_first;
+		ArcType m_weight;
+
+	public:
+		ArcCursor( const CompressedGraph* pGraph, int node, const unsigned char* pBegin, const unsigned char* pEnd ) :
+			m_pGraph( pGraph ), m_pNext( pBegin ), m_pEnd( pEnd ), m_node( node ), m_first( true ), m_weight( 0 ) {
+		}
+
+		// ----------------------------------------------------------------
+		//  Name:           next
+		//  Description:    Moves on to the next arc.
+		//  Arguments:      None.
+		//  Return Value:   false once there are no arcs left.
+		// ----------------------------------------------------------------
+		bool next() {
+			if( m_pNext == m_pEnd ) {
+				return false;
+			}
+			unsigned int gap = 0;
+			int shift = 0;
+			while( *m_pNext & 0x80 ) {
+				gap |= (unsigned int)(*m_pNext++ & 0x7f) << shift;
+				shift += 7;
+			}
+			gap |= (unsigned int)(*m_pNext++) << shift;
+			if( m_first == true ) {
+				m_node += (int)(gap >> 1) ^ -(int)(gap & 1);
+				m_first = false;
+			}
+			else {
+				m_node += (int)gap;
+			}
+
+			if( m_pGraph->m_narrowWeights == true ) {
+				m_weight = m_pGraph->m_minWeight + (ArcType)(m_pNext[0] | (m_pNext[1] << 8));
+				m_pNext += 2;
+			}
+			else {
+				memcpy( &m_weight, m_pNext, sizeof( ArcType ) );
+				m_pNext += sizeof( ArcType );
+			}
+			return true;
+		}
+
+		int node() const {
+			return m_node;
+		}
+
+		ArcType weight() const {
+			return m_weight;
+		}
+	};
+
+	CompressedGraph() : m_pOffsets( 0 ), m_pX( 0 ), m_pY( 0 ), m_pBytes( 0 ), m_size( 0 ), m_byteCount( 0 ),
+		m_narrowWeights( false ), m_minWeight( 0 ), m_arcCount( 0 ) {
+	}
+
+	CompressedGraph( const CompressedGraph& source, void* pBlock );
+
+	template<class NodeType>
+	void build( Graph<NodeType, ArcType>& graph );
+
+	ArcCursor arcs( int node ) const {
+		return ArcCursor( this, node, m_pBytes + m_pOffsets[node], m_pBytes + m_pOffsets[node + 1] );
+	}
+
+	int size() const {
+		return m_size;
+	}
+
+	// the same as size(), as Graph::maxSize is for the search engine.
+	int maxSize() const {
+		return m_size;
+	}
+
+	int arcCount() const {
+		return m_arcCount;
+	}
+
+	// ----------------------------------------------------------------
+	//  Name:           bytes
+	//  Description:    Size of the block holding the arcs, offsets and
+	//                  positions, which is what a placed copy needs.
+	//  Arguments:      None.
+	//  Return Value:   The size in bytes.
+	// ----------------------------------------------------------------
+	size_t bytes() const {
+		return (m_size + 1) * sizeof( size_t ) + 2 * m_size * sizeof( int ) + m_byteCount;
+	}
+
+	// the same estimate as Graph::estimate.
+	ArcType estimate( int from, int to ) const {
+		double dx = m_pX[to] - m_pX[from];
+		double dy = m_pY[to] - m_pY[from];
+		return (ArcType)((sqrt( dx * dx + dy * dy ) * 90) / 100);
+	}
+
+	void breadthFirst( int start, vector<int>& hops ) const;
+	QuerySummary<ArcType> boundedSearch( int start, int goal, const QueryOptions& options, SearchState<ArcType>& state ) const;
+
+	// a search by an engine the caller has put together, with its own
+	// open list, heuristic or search state.
+	template<class Engine, class State>
+	QuerySummary<ArcType> boundedSearch( int start, int goal, const QueryOptions& options, State& state, Engine& engine ) const {
+		return engine.run( *this, start, goal, options, state );
+	}
+};
+
+// ----------------------------------------------------------------
+//  Name:           build
+//  Description:    Packs a graph's arcs. Node indices stay the same,
+//                  so results map straight back to the graph. Calling
+//                  Graph::reorder first keeps neighbours' indices
+//                  close together, which makes the gaps smaller.
+//  Arguments:      The graph.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class ArcType>
+template<class NodeType>
+void CompressedGraph<ArcType>::build( Graph<NodeType, ArcType>& graph ) {
+	typedef GraphArc<NodeType, ArcType> Arc;
+	int count = graph.maxSize();
+
+	// the weights decide how they will be stored.
+	bool any = false;
+	ArcType minWeight = 0;
+	ArcType maxWeight = 0;
+	m_arcCount = 0;
+	for( int i = 0; i < count; i++ ) {
+		if( graph.nodeArray()[i] == 0 ) {
+			continue;
+		}
+		typename list<Arc>::const_iterator iter = graph.nodeArray()[i]->arcList().begin();
+		typename list<Arc>::const_iterator endIter = graph.nodeArray()[i]->arcList().end();
+		for( ; iter != endIter; ++iter ) {
+			if( any == false || (*iter).weight() < minWeight ) {
+				minWeight = (*iter).weight();
+			}
+			if( any == false || (*iter).weight() > maxWeight ) {
+				maxWeight = (*iter).weight();
+			}
+			any = true;
+			m_arcCount++;
+		}
+	}
+	m_minWeight = minWeight;
+	m_narrowWeights = numeric_limits<ArcType>::is_integer && (double)maxWeight - (double)minWeight <= 65535;
+
+	vector<size_t> offsets( 1, 0 );
+	vector<unsigned char> packed;
+	vector<int> x( count, 0 );
+	vector<int> y( count, 0 );
+	vector< pair<int, ArcType> > sorted;
+	for( int i = 0; i < count; i++ ) {
+		GraphNode<NodeType, ArcType>* pNode = graph.nodeArray()[i];
+		if( pNode != 0 ) {
+			x[i] = pNode->getX();
+			y[i] = pNode->getY();
+
+			sorted.clear();
+			typename list<Arc>::const_iterator iter = pNode->arcList().begin();
+			typename list<Arc>::const_iterator endIter = pNode->arcList().end();
+			for( ; iter != endIter; ++iter ) {
+				sorted.push_back( pair<int, ArcType>( (*iter).node()->getIndex(), (*iter).weight() ) );
+			}
+			sort( sorted.begin(), sorted.end() );
+
+			int previous = i;
+			for( size_t j = 0; j < sorted.size(); j++ ) {
+				int gap = sorted[j].first - previous;
+				if( j == 0 ) {
+					writeNumber( packed, ((unsigned int)gap << 1) ^ (unsigned int)(gap >> 31) );
+				}
+				else {
+					writeNumber( packed, (unsigned int)gap );
+				}
+				writeWeight( packed, sorted[j].second );
+				previous = sorted[j].first;
+			}
+		}
+		offsets.push_back( packed.size() );
+	}
+
+	// gather the arrays into one block.
+	m_size = count;
+	m_byteCount = packed.size();
+	vector<unsigned char>( bytes() ).swap( m_storage );
+	unsigned char* pBlock = &m_storage[0];
+	memcpy( pBlock, &offsets[0], offsets.size() * sizeof( size_t ) );
+	pBlock += offsets.size() * sizeof( size_t );
+	if( count > 0 ) {
+		memcpy( pBlock, &x[0], count * sizeof( int ) );
+		memcpy( pBlock + count * sizeof( int ), &y[0], count * sizeof( int ) );
+		pBlock += 2 * count * sizeof( int );
+	}
+	if( m_byteCount > 0 ) {
+		memcpy( pBlock, &packed[0], m_byteCount );
+	}
+	place( &m_storage[0] );
+}
+
+// ----------------------------------------------------------------
+//  Name:           CompressedGraph
+//  Description:    Copy constructor that puts the copy's arrays in a
+//                  block of memory the caller owns, such as memory on
+//                  a particular NUMA node. The block must hold at
+//                  least source.bytes() bytes, be aligned for size_t
+//                  and outlive the copy.
+//  Arguments:      The first parameter is the graph to copy.
+//                  The second parameter is the block.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class ArcType>
+CompressedGraph<ArcType>::CompressedGraph( const CompressedGraph& source, void* pBlock ) :
+	m_size( source.m_size ), m_byteCount( source.m_byteCount ), m_narrowWeights( source.m_narrowWeights ),
+	m_minWeight( source.m_minWeight ), m_arcCount( source.m_arcCount ) {
+	memcpy( pBlock, source.m_pOffsets, source.bytes() );
+	place( (unsigned char*)pBlock );
+}
+
+// ----------------------------------------------------------------
+//  Name:           breadthFirst
+//  Description:    Counts the fewest arcs from a node to every other.
+//  Arguments:      The first parameter is the start node index.
+//                  The second parameter is filled with the hop counts,
+//                  -1 for nodes that can't be reached.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class ArcType>
+void CompressedGraph<ArcType>::breadthFirst( int start, vector<int>& hops ) const {
+	hops.assign( size(), -1 );
+	vector<int> queue;
+	queue.reserve( size() );
+	hops[start] = 0;
+	queue.push_back( start );
+	for( size_t head = 0; head < queue.size(); head++ ) {
+		int node = queue[head];
+		ArcCursor cursor = arcs( node );
+		while( cursor.next() == true ) {
+			if( hops[cursor.node()] == -1 ) {
+				hops[cursor.node()] = hops[node] + 1;
+				queue.push_back( cursor.node() );
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           boundedSearch
+//  Description:    The same A* search with limits as
+//                  Graph::boundedSearch, run by the same engine
+//                  reading the packed arcs.
+//  Arguments:      The first parameter is the start node index.
+//                  The second parameter is the goal node index.
+//                  The third parameter holds the limits.
+//                  The fourth parameter is scratch space to reuse.
+//  Return Value:   The outcome, cost and end of the path.
+// ----------------------------------------------------------------
+template<class ArcType>
+QuerySummary<ArcType> CompressedGraph<ArcType>::boundedSearch( int start, int goal, const QueryOptions& options, SearchState<ArcType>& state ) const {
+	SearchEngine<CompressedGraph, ArcType> engine;
+	engine.openList().useStorage( state.open );
+	return engine.run( *this, start, goal, options, state );
+}
+
+#endif
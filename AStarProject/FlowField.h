@@ -0,0 +1,208 @@
+#ifndef FLOWFIELD_H
+#define FLOWFIELD_H
+
+#include <vector>
+#include <queue>
+#include <list>
+#include <map>
+#include <limits>
+#include <utility>
+#include <functional>
+
+#include "Graph.h"
+
+// ----------------------------------------------------------------
+//  Name:           FlowField
+//  Description:    Distance and next step to one goal from every
+//                  node, built by a single search backwards from the
+//                  goal along the incoming arcs. Any number of agents
+//                  can then walk to the goal by following next, with
+//                  no further searching.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+class FlowField {
+private:
+	int m_goal;
+	unsigned int m_version;
+
+	// ----------------------------------------------------------------
+	//  Description:    Cost from every node to the goal (numeric max if
+	//                  the goal can't be reached) and the index of the
+	//                  next node on the way (-1 for none).
+	// ----------------------------------------------------------------
+	vector<ArcType> m_distance;
+	vector<int> m_next;
+
+public:
+	FlowField( Graph<NodeType, ArcType>& graph, int goal );
+
+	int goal() const {
+		return m_goal;
+	}
+
+	// the graph version the field was built from.
+	unsigned int version() const {
+		return m_version;
+	}
+
+	ArcType distance( int node ) const {
+		return m_distance[node];
+	}
+
+	int next( int node ) const {
+		return m_next[node];
+	}
+
+	bool path( int start, vector<int>& path ) const;
+};
+
+// ----------------------------------------------------------------
+//  Name:           FlowField
+//  Description:    Constructor, runs a uniform cost search from the
+//                  goal over the reversed arcs.
+//  Arguments:      The first parameter is the graph.
+//                  The second parameter is the goal node index.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+FlowField<NodeType, ArcType>::FlowField( Graph<NodeType, ArcType>& graph, int goal ) :
+	m_goal( goal ), m_version( graph.version() ) {
+	typedef pair<ArcType, int> Entry;
+	const ArcType infinity = numeric_limits<ArcType>::max();
+
+	vector<int> offsets;
+	vector<int> sources;
+	vector<ArcType> weights;
+	graph.reverseArcs( offsets, sources, weights );
+
+	m_distance.assign( graph.maxSize(), infinity );
+	m_next.assign( graph.maxSize(), -1 );
+
+	priority_queue< Entry, vector<Entry>, greater<Entry> > nodeQueue;
+	m_distance[goal] = 0;
+	nodeQueue.push( Entry( 0, goal ) );
+	while( nodeQueue.size() != 0 ) {
+		Entry top = nodeQueue.top();
+		nodeQueue.pop();
+		if( top.first > m_distance[top.second] ) {
+			continue;
+		}
+		// every arc into this node gives its source a way to the goal.
+		for( int slot = offsets[top.second]; slot < offsets[top.second + 1]; slot++ ) {
+			int from = sources[slot];
+			ArcType distance = top.first + weights[slot];
+			if( distance < m_distance[from] ) {
+				m_distance[from] = distance;
+				m_next[from] = top.second;
+				nodeQueue.push( Entry( distance, from ) );
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           path
+//  Description:    Follows the field from a node to the goal.
+//  Arguments:      The first parameter is the start node index.
+//                  The second parameter is filled with the node
+//                  indices from start to goal.
+//  Return Value:   true if the goal can be reached.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+bool FlowField<NodeType, ArcType>::path( int start, vector<int>& path ) const {
+	path.clear();
+	if( m_distance[start] == numeric_limits<ArcType>::max() ) {
+		return false;
+	}
+	for( int node = start; node != -1; node = m_next[node] ) {
+		path.push_back( node );
+	}
+	return true;
+}
+
+// ----------------------------------------------------------------
+//  Name:           FlowFieldCache
+//  Description:    Keeps the flow fields of the most recently used
+//                  goals, dropping the least recently used one when
+//                  full. Every field is thrown away as soon as the
+//                  graph's version moves on.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+class FlowFieldCache {
+private:
+	typedef FlowField<NodeType, ArcType> Field;
+
+	Graph<NodeType, ArcType>& m_graph;
+	size_t m_maxFields;
+	unsigned int m_version;
+
+	typedef pair<int, Field*> Entry;
+
+	// goals and their fields, least recently used first, and where
+	// each goal is in that list.
+	list<Entry> m_order;
+	map<int, typename list<Entry>::iterator> m_fields;
+
+public:
+	FlowFieldCache( Graph<NodeType, ArcType>& graph, size_t maxFields = 16 ) :
+		m_graph( graph ), m_maxFields( maxFields > 0 ? maxFields : 1 ), m_version( graph.version() ) {
+	}
+
+	~FlowFieldCache() {
+		clear();
+	}
+
+	const Field& field( int goal );
+	void clear();
+};
+
+// ----------------------------------------------------------------
+//  Name:           field
+//  Description:    Gets the flow field to a goal, building it if it
+//                  isn't cached or the graph has changed.
+//  Arguments:      The goal node index.
+//  Return Value:   The flow field, valid until the next call.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+const FlowField<NodeType, ArcType>& FlowFieldCache<NodeType, ArcType>::field( int goal ) {
+	if( m_version != m_graph.version() ) {
+		clear();
+		m_version = m_graph.version();
+	}
+
+	typename map<int, typename list<Entry>::iterator>::iterator iter = m_fields.find( goal );
+	if( iter != m_fields.end() ) {
+		// move it to the back of the list.
+		m_order.splice( m_order.end(), m_order, iter->second );
+		return *iter->second->second;
+	}
+
+	// make room by dropping the least recently used field.
+	if( m_fields.size() >= m_maxFields ) {
+		delete m_order.front().second;
+		m_fields.erase( m_order.front().first );
+		m_order.pop_front();
+	}
+	Field* pField = new Field( m_graph, goal );
+	m_order.push_back( Entry( goal, pField ) );
+	m_fields[goal] = --m_order.end();
+	return *pField;
+}
+
+// ----------------------------------------------------------------
+//  Name:           clear
+//  Description:    Deletes every cached field.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void FlowFieldCache<NodeType, ArcType>::clear() {
+	typename list<Entry>::iterator iter = m_order.begin();
+	for( ; iter != m_order.end(); ++iter ) {
+		delete iter->second;
+	}
+	m_fields.clear();
+	m_order.clear();
+}
+
+#endif
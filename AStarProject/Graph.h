@@ -3,11 +3,32 @@
 
 #include <list>
 #include <queue>
+#include <vector>
+#include <limits>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <map>
+#include <functional>
+#include <iostream>
+#include <string>
+
+#include "SpatialIndex.h"
+#include "SearchQuery.h"
+#include "SearchEngine.h"
+#include "WorkerTeam.h"
+
+// Define GRAPH_NO_SFML before including this file to leave out the
+// viewer's drawing and mouse handling, so tools can use the graph
+// without SFML.
 
 using namespace std;
 
 template <class NodeType, class ArcType> class GraphArc;
 template <class NodeType, class ArcType> class GraphNode;
+template <class NodeType, class ArcType> class GraphVisitor;
 
 // ----------------------------------------------------------------
 //  Name:           Graph
@@ -49,13 +70,121 @@ private:
 	string goalNode;
 	int pathCost;
 
+#ifndef GRAPH_NO_SFML
 	sf::Texture nodeInfoTexture;
 	sf::Sprite nodeInfo;
 	sf::Text gn;
 	sf::Text hn;
 	sf::Font font;
+#endif
+
+	// ----------------------------------------------------------------
+	//  Description:    k-d tree of the node positions used to find
+	//                  the node under the mouse, rebuilt when nodes
+	//                  are added, removed or reordered.
+	// ----------------------------------------------------------------
+	SpatialIndex m_spatialIndex;
+	bool m_spatialValid;
+
+	// the node currently under the mouse, or -1.
+	int m_hovered;
+
+	// ----------------------------------------------------------------
+	//  Description:    Nodes whose colour changed since the view last
+	//                  took the list, each listed once, so redrawing
+	//                  costs only what changed.
+	// ----------------------------------------------------------------
+	vector<int> m_colorChanges;
+
+	// ----------------------------------------------------------------
+	//  Description:    Bumped every time nodes or arcs change, so
+	//                  anything derived from the graph can tell when
+	//                  it is stale.
+	// ----------------------------------------------------------------
+	unsigned int m_version;
+
+	// ----------------------------------------------------------------
+	//  Description:    Connectivity index. Weak components are merged
+	//                  as arcs are added; strong components are numbered
+	//                  in reverse topological order, so a node can only
+	//                  reach components with a lower or equal number.
+	// ----------------------------------------------------------------
+	vector<int> m_weakComponent;
+	vector< vector<int> > m_weakMembers;
+	vector<int> m_strongComponent;
+	int m_strongCount;
+	bool m_weakValid;
+	bool m_strongValid;
+
+	void buildWeakComponents();
+	void buildStrongComponents();
+	bool knownUnreachable( int from, int to ) const;
+
+	// ----------------------------------------------------------------
+	//  Description:    Original index of each node after reorder, and
+	//                  the reverse map. Both are empty until the first
+	//                  reorder, meaning the indices are unchanged.
+	// ----------------------------------------------------------------
+	vector<int> m_externalIds;
+	vector<int> m_internalIds;
+
+	// ----------------------------------------------------------------
+	//  Description:    Nodes in each category, so targets can be
+	//                  found without scanning the graph.
+	// ----------------------------------------------------------------
+	map< int, vector<int> > m_categories;
+
+	void breadthFirstOrder( vector<int>& order, bool byDegree );
+	static unsigned long long hilbertIndex( unsigned int x, unsigned int y );
+
+	// runs pWork over [0, count) split into one chunk per team member.
+	template<class Work>
+	void parallelFor( WorkerTeam& team, int count, Work pWork );
 
 public:           
+	// Node orderings used by reorder.
+	enum Ordering {
+		HILBERT_ORDER,	// along a Hilbert curve through the node positions
+		BFS_ORDER,		// breadth-first from the lowest index
+		RCM_ORDER		// reverse Cuthill-McKee
+	};
+
+	// ----------------------------------------------------------------
+	//  Name:           ArcCursor
+	//  Description:    Walks the arcs of one node by index, the way
+	//                  SearchEngine reads any graph. Call next() before
+	//                  reading the first arc.
+	// ----------------------------------------------------------------
+	class ArcCursor {
+	private:
+		typename list<Arc>::const_iterator m_iter;
+		typename list<Arc>::const_iterator m_end;
+		int m_node;
+		ArcType m_weight;
+
+	public:
+		ArcCursor( const list<Arc>& arcs ) : m_iter( arcs.begin() ), m_end( arcs.end() ), m_node( -1 ), m_weight( 0 ) {
+		}
+
+		bool next() {
+			if( m_iter == m_end ) {
+				return false;
+			}
+			m_node = (*m_iter).node()->getIndex();
+			m_weight = (*m_iter).weight();
+			++m_iter;
+			return true;
+		}
+
+		int node() const {
+			return m_node;
+		}
+
+		ArcType weight() const {
+			return m_weight;
+		}
+	};
+
 	// Constructor and destructor functions
 	Graph( int size );
 	~Graph();
@@ -65,10 +194,44 @@ public:
 		return m_pNodes;
 	}
 
+	// maps between the indices used when the graph was loaded
+	// and the current ones after a reorder.
+	int externalIndex( int index ) const {
+		return m_externalIds.size() == 0 ? index : m_externalIds[index];
+	}
+
+	int internalIndex( int index ) const {
+		return m_internalIds.size() == 0 ? index : m_internalIds[index];
+	}
+
 	int size() const {
 		return m_count;
 	}
 
+	int maxSize() const {
+		return m_maxNodes;
+	}
+
+	unsigned int version() const {
+		return m_version;
+	}
+
+	ArcCursor arcs( int node ) const {
+		return ArcCursor( m_pNodes[node]->arcList() );
+	}
+
+	// hands over the nodes whose colour has changed since the last
+	// call, and starts a new list.
+	void takeColorChanges( vector<int>& changed ) {
+		changed.clear();
+		changed.swap( m_colorChanges );
+		for( size_t i = 0; i < changed.size(); i++ ) {
+			if( m_pNodes[changed[i]] != 0 ) {
+				m_pNodes[changed[i]]->clearColorChange();
+			}
+		}
+	}
+
 	bool startSelected() {
 		return start;
 	}
@@ -103,18 +266,50 @@ public:
 	void removeNode( int index );
 	bool addArc( int from, int to, ArcType weight );
 	void removeArc( int from, int to );
+	bool setArcWeight( int from, int to, ArcType weight );
 	Arc* getArc( int from, int to );        
 	void clearMarks();
 	void depthFirst( Node* pNode, void (*pProcess)(Node*) );
 	void breadthFirst( Node* pNode, void (*pProcess)(Node*) );
+	template<class Visitor>
+	void depthFirstVisit( Node* pNode, Visitor& visitor );
+	template<class Visitor>
+	void breadthFirstVisit( Node* pNode, Visitor& visitor );
 	void breadthFirstSearch( Node* pNode, void (*pProcess)(Node*),  NodeType data );
 	void UCS( Node* pNode, Node* goal);
+	void deltaStepping( Node* pNode, ArcType delta, ArcType* distance, int* previous, int threads = 0 );
+	void parallelBreadthFirst( Node* pNode, int* hops, int* previous, int threads = 0 );
+	void reverseArcs( vector<int>& offsets, vector<int>& sources, vector<ArcType>& weights );
+	void buildComponents();
+	bool componentLabels( vector<int>& weak, vector<int>& strong ) const;
+	bool setComponentLabels( const int* weak, const int* strong, int count );
+	bool reachable( Node* from, Node* to );
+	void reorder( Ordering ordering );
+	const SpatialIndex& spatialIndex();
+	ArcType estimate( Node* from, Node* to ) const;
+	ArcType estimate( int from, int to ) const {
+		return estimate( m_pNodes[from], m_pNodes[to] );
+	}
+	void setCategory( int index, int category );
+	template<class Classify>
+	void buildCategories( Classify pClassify );
+	const vector<int>& categoryMembers( int category );
+	void nearestInCategory( Node* pNode, int category, int count, vector< pair<int, ArcType> >& found, SearchState<ArcType>& state );
+	void nearestInCategory( Node* pNode, int category, int count, vector< pair<int, ArcType> >& found );
+	void assignNearest( int category, ArcType* distance, int* facility );
 	void AStar(Node* start, Node* goal, std::vector<Node*> &path );
+	QuerySummary<ArcType> boundedSearch( int start, int goal, const QueryOptions& options, SearchState<ArcType>& state ) const;
+	template<class Engine, class State>
+	QuerySummary<ArcType> boundedSearch( int start, int goal, const QueryOptions& options, State& state, Engine& engine ) const;
+	void boundedSearch( int start, int goal, const QueryOptions& options, QueryResult<ArcType>& result, SearchState<ArcType>& state ) const;
+	void boundedSearch( int start, int goal, const QueryOptions& options, QueryResult<ArcType>& result ) const;
 	void resetNodes();
+#ifndef GRAPH_NO_SFML
 	void drawNodes(sf::RenderWindow window);
 	void checkMousePos(sf::RenderWindow &window);
 	void selectNodes(sf::RenderWindow &window);
 	void drawNodeInfo(sf::RenderWindow &window);
+#endif
 };
 
 // ----------------------------------------------------------------
@@ -140,6 +335,7 @@ Graph<NodeType, ArcType>::Graph( int size ) : m_maxNodes( size ) {
 	goalNode = "";
 	pathCost = 0;
 
+#ifndef GRAPH_NO_SFML
 	nodeInfoTexture;
 	if (!nodeInfoTexture.loadFromFile("nodeInfo.png")) {
 		cout << "No image with that name found";
@@ -149,9 +345,17 @@ Graph<NodeType, ArcType>::Graph( int size ) : m_maxNodes( size ) {
 	nodeInfo.setPosition(-1000, -1000);
 
 	font.loadFromFile("C:\\Windows\\Fonts\\GARA.TTF");
+#endif
 
 	// set the node count to 0.
 	m_count = 0;
+
+	m_version = 0;
+	m_spatialValid = false;
+	m_hovered = -1;
+	m_strongCount = 0;
+	m_weakValid = false;
+	m_strongValid = false;
 }
 
 // ----------------------------------------------------------------
@@ -190,9 +394,22 @@ bool Graph<NodeType, ArcType>::addNode( NodeType data, int index, std::pair<int,
 		m_pNodes[index]->setData(data);
 		m_pNodes[index]->setMarked(false);
 		m_pNodes[index]->setPosition(pos);
+		m_pNodes[index]->setIndex(index);
+		m_pNodes[index]->trackColor(&m_colorChanges);
+
+		// a new node starts in a component of its own.
+		if( m_weakValid == true ) {
+			m_weakComponent[index] = (int)m_weakMembers.size();
+			m_weakMembers.push_back( vector<int>( 1, index ) );
+		}
+		if( m_strongValid == true ) {
+			m_strongComponent[index] = m_strongCount++;
+		}
 
 		// increase the count and return success.
 		m_count++;
+		m_version++;
+		m_spatialValid = false;
 	}
 
 	return nodeNotPresent;
@@ -230,9 +447,16 @@ void Graph<NodeType, ArcType>::removeNode( int index ) {
 
 		// now that every arc pointing to the current node has been removed,
 		// the node can be deleted.
+		setCategory( index, -1 );
 		delete m_pNodes[index];
 		m_pNodes[index] = 0;
 		m_count--;
+		m_version++;
+		m_spatialValid = false;
+		m_hovered = -1;
+
+		m_weakValid = false;
+		m_strongValid = false;
 	}
 }
 
@@ -254,13 +478,33 @@ bool Graph<NodeType, ArcType>::addArc( int from, int to, ArcType weight ) {
 	}
 
 	// if an arc already exists we should not proceed
-	if( m_pNodes[from]->getArc( m_pNodes[to] ) != 0 ) {
+	else if( m_pNodes[from]->getArc( m_pNodes[to] ) != 0 ) {
 		proceed = false;
 	}
 
 	if (proceed == true) {
 		// add the arc to the "from" node.
 		m_pNodes[from]->addArc( m_pNodes[to], weight );
+		m_version++;
+
+		// merge the smaller weak component into the larger one.
+		if( m_weakValid == true && m_weakComponent[from] != m_weakComponent[to] ) {
+			int keep = m_weakComponent[from];
+			int merge = m_weakComponent[to];
+			if( m_weakMembers[keep].size() < m_weakMembers[merge].size() ) {
+				std::swap( keep, merge );
+			}
+			for( size_t i = 0; i < m_weakMembers[merge].size(); i++ ) {
+				m_weakComponent[m_weakMembers[merge][i]] = keep;
+			}
+			m_weakMembers[keep].insert( m_weakMembers[keep].end(), m_weakMembers[merge].begin(), m_weakMembers[merge].end() );
+			vector<int>().swap( m_weakMembers[merge] );
+		}
+		// an arc down the topological order keeps the strong components,
+		// anything else may join them and needs a rebuild.
+		if( m_strongValid == true && m_strongComponent[from] < m_strongComponent[to] ) {
+			m_strongValid = false;
+		}
 	}
 
 	return proceed;
@@ -285,10 +529,37 @@ void Graph<NodeType, ArcType>::removeArc( int from, int to ) {
 	if (nodeExists == true) {
 		// remove the arc.
 		m_pNodes[from]->removeArc( m_pNodes[to] );
+		m_version++;
+
+		// the arc may have been the only link between two components.
+		m_weakValid = false;
+		m_strongValid = false;
 	}
 }
 
 
+// ----------------------------------------------------------------
+//  Name:           setArcWeight
+//  Description:    Changes the weight of the arc from the first index
+//                  to the second index. Use this rather than changing
+//                  the arc directly so cached results are invalidated.
+//  Arguments:      The first parameter is the originating node index.
+//                  The second parameter is the ending node index.
+//                  The third parameter is the new weight.
+//  Return Value:   true if the arc exists.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+bool Graph<NodeType, ArcType>::setArcWeight( int from, int to, ArcType weight ) {
+	Arc* pArc = getArc( from, to );
+	if( pArc != 0 ) {
+		pArc->setWeight( weight );
+		m_version++;
+	}
+
+	return pArc != 0;
+}
+
+
 // ----------------------------------------------------------------
 //  Name:           getArc
 //  Description:    Gets a pointer to an arc from the first index
@@ -330,71 +601,189 @@ void Graph<NodeType, ArcType>::clearMarks() {
 // ----------------------------------------------------------------
 //  Name:           depthFirst
 //  Description:    Performs a depth-first traversal on the specified 
-//                  node.
+//                  node, marking each node as it is processed. Nodes
+//                  that are already marked are not entered.
 //  Arguments:      The first argument is the starting node
 //                  The second argument is the processing function.
 //  Return Value:   None.
 // ----------------------------------------------------------------
 template<class NodeType, class ArcType>
 void Graph<NodeType, ArcType>::depthFirst( Node* pNode, void (*pProcess)(Node*) ) {
-	if( pNode != 0 ) {
-		// process the current node and mark it
-		pProcess( pNode );
-		pNode->setMarked(true);
-
-		// go through each connecting node
-		list<Arc>::iterator iter = pNode->arcList().begin();
-		list<Arc>::iterator endIter = pNode->arcList().end();
+	struct MarkingVisitor : public GraphVisitor<NodeType, ArcType> {
+		void (*m_pProcess)(Node*);
+
+		bool visit( Node* pNode ) {
+			// process the current node and mark it
+			m_pProcess( pNode );
+			pNode->setMarked(true);
+			return true;
+		}
 
-		for( ; iter != endIter; ++iter) {
-			// process the linked node if it isn't already marked.
-			if ( (*iter).node()->marked() == false ) {
-				depthFirst( (*iter).node(), pProcess);
-			}            
+		bool follow( Node* /*pFrom*/, Node* pTo ) {
+			return pTo->marked() == false;
 		}
-	}
+	};
+
+	MarkingVisitor visitor;
+	visitor.m_pProcess = pProcess;
+	depthFirstVisit( pNode, visitor );
 }
 
 
 // ----------------------------------------------------------------
 //  Name:           breadthFirst
-//  Description:    Performs a depth-first traversal the starting node
-//                  specified as an input parameter.
+//  Description:    Performs a breadth-first traversal the starting node
+//                  specified as an input parameter, marking each node
+//                  and remembering the node it was reached from. Nodes
+//                  that are already marked are not queued.
 //  Arguments:      The first parameter is the starting node
 //                  The second parameter is the processing function.
 //  Return Value:   None.
 // ----------------------------------------------------------------
 template<class NodeType, class ArcType>
 void Graph<NodeType, ArcType>::breadthFirst( Node* pNode, void (*pProcess)(Node*) ) {
+	struct MarkingVisitor : public GraphVisitor<NodeType, ArcType> {
+		void (*m_pProcess)(Node*);
+
+		bool visit( Node* pNode ) {
+			m_pProcess( pNode );
+			return true;
+		}
+
+		bool follow( Node* /*pFrom*/, Node* pTo ) {
+			return pTo->marked() == false;
+		}
+
+		void treeArc( Node* pFrom, Node* pTo ) {
+			pTo->setMarked(true);
+			pTo->setPrevious(pFrom);
+		}
+	};
+
 	if( pNode != 0 ) {
-		queue<Node*> nodeQueue;        
-		// place the first node on the queue, and mark it.
-		nodeQueue.push( pNode );
+		MarkingVisitor visitor;
+		visitor.m_pProcess = pProcess;
 		pNode->setMarked(true);
+		breadthFirstVisit( pNode, visitor );
+	}
+}
 
-		// loop through the queue while there are nodes in it.
-		while( nodeQueue.size() != 0 ) {
-			// process the node at the front of the queue.
-			pProcess( nodeQueue.front() );
 
-			// add all of the child nodes that have not been 
-			// marked into the queue
-			list<Arc>::const_iterator iter = nodeQueue.front()->arcList().begin();
-			list<Arc>::const_iterator endIter = nodeQueue.front()->arcList().end();
+// ----------------------------------------------------------------
+//  Name:           depthFirstVisit
+//  Description:    Iterative depth-first traversal. An explicit stack
+//                  of (node, next arc) pairs replaces the recursion,
+//                  so it visits in the same order as the recursive
+//                  version but cannot overflow on long chains. Visited
+//                  nodes are tracked locally, so node marks are not
+//                  needed or changed; a visitor that wants them
+//                  honoured says so in follow.
+//  Arguments:      The first parameter is the starting node.
+//                  The second parameter is the visitor (see
+//                  GraphVisitor); its hooks are called directly.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+template<class Visitor>
+void Graph<NodeType, ArcType>::depthFirstVisit( Node* pNode, Visitor& visitor ) {
+	struct Frame {
+		Node* node;
+		typename list<Arc>::const_iterator iter;
+	};
+
+	if( pNode == 0 ) {
+		return;
+	}
 
-			for( ; iter != endIter; iter++ ) {
-				if ( (*iter).node()->marked() == false) {
-					// mark the node and add it to the queue.
-					(*iter).node()->setMarked(true);
-					(*iter).node()->setPrevious(nodeQueue.front());
-					nodeQueue.push( (*iter).node() );
+	vector<bool> visited( m_maxNodes, false );
+	vector<Frame> nodeStack;
+
+	visited[pNode->getIndex()] = true;
+	if( visitor.visit( pNode ) == false ) {
+		return;
+	}
+	Frame first = { pNode, pNode->arcList().begin() };
+	nodeStack.push_back( first );
+
+	while( nodeStack.size() != 0 ) {
+		Frame& frame = nodeStack.back();
+
+		if( frame.iter != frame.node->arcList().end() ) {
+			Node* pFrom = frame.node;
+			Node* pTo = (*frame.iter).node();
+			++frame.iter;
+			// descend into the linked node if it hasn't been seen yet.
+			if( visited[pTo->getIndex()] == false && visitor.follow( pFrom, pTo ) == true ) {
+				visited[pTo->getIndex()] = true;
+				visitor.treeArc( pFrom, pTo );
+				if( visitor.visit( pTo ) == false ) {
+					return;
 				}
+				Frame child = { pTo, pTo->arcList().begin() };
+				nodeStack.push_back( child );
+			}
+		}
+		else {
+			// every arc is done, so leave the node.
+			Node* pDone = frame.node;
+			nodeStack.pop_back();
+			if( visitor.leave( pDone ) == false ) {
+				return;
 			}
+		}
+	}
+}
 
-			// dequeue the current node.
-			nodeQueue.pop();
+
+// ----------------------------------------------------------------
+//  Name:           breadthFirstVisit
+//  Description:    Breadth-first traversal with a compile-time
+//                  visitor. Nodes are visited as they leave the queue
+//                  and left once all of their arcs are queued. Visited
+//                  nodes are tracked locally, so node marks are not
+//                  needed or changed; a visitor that wants them
+//                  honoured says so in follow.
+//  Arguments:      The first parameter is the starting node.
+//                  The second parameter is the visitor (see
+//                  GraphVisitor); its hooks are called directly.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+template<class Visitor>
+void Graph<NodeType, ArcType>::breadthFirstVisit( Node* pNode, Visitor& visitor ) {
+	if( pNode == 0 ) {
+		return;
+	}
+
+	vector<bool> visited( m_maxNodes, false );
+	queue<Node*> nodeQueue;
+	nodeQueue.push( pNode );
+	visited[pNode->getIndex()] = true;
+
+	// loop through the queue while there are nodes in it.
+	while( nodeQueue.size() != 0 ) {
+		Node* pFront = nodeQueue.front();
+		nodeQueue.pop();
+		if( visitor.visit( pFront ) == false ) {
+			return;
 		}
-	}  
+
+		// queue every linked node that hasn't been seen yet.
+		typename list<Arc>::const_iterator iter = pFront->arcList().begin();
+		typename list<Arc>::const_iterator endIter = pFront->arcList().end();
+		for( ; iter != endIter; ++iter ) {
+			Node* pTo = (*iter).node();
+			if( visited[pTo->getIndex()] == false && visitor.follow( pFront, pTo ) == true ) {
+				visited[pTo->getIndex()] = true;
+				visitor.treeArc( pFront, pTo );
+				nodeQueue.push( pTo );
+			}
+		}
+
+		if( visitor.leave( pFront ) == false ) {
+			return;
+		}
+	}
 }
 
 template<class NodeType, class ArcType>
@@ -486,68 +875,1207 @@ void Graph<NodeType, ArcType>::UCS( Node* pNode, Node* goal)
 	}
 }
 
+// ----------------------------------------------------------------
+//  Name:           parallelFor
+//  Description:    Splits the range [0, count) into one chunk per
+//                  team member and runs the work function on each
+//                  chunk. Small ranges are run on the calling thread.
+//  Arguments:      The first parameter is the team to run on.
+//                  The second parameter is the size of the range.
+//                  The third parameter is called as (begin, end, member).
+//  Return Value:   None.
+// ----------------------------------------------------------------
 template<class NodeType, class ArcType>
-void Graph<NodeType, ArcType>::AStar(Node* start, Node* goal, std::vector<Node*> &path ) {
+template<class Work>
+void Graph<NodeType, ArcType>::parallelFor( WorkerTeam& team, int count, Work pWork ) {
+	const int minChunk = 1024;
+	int chunks = (count + minChunk - 1) / minChunk;
+	if( chunks > team.size() ) {
+		chunks = team.size();
+	}
 
-	GraphNode<NodeType, ArcType>* foundNode;
-	priority_queue<Node*, vector<Node *>, NodeSearchCostComparer> nodeQueue;
+	if( chunks <= 1 ) {
+		pWork( 0, count, 0 );
+	}
+	else {
+		int chunk = (count + chunks - 1) / chunks;
+		team.run( [&]( int member ) {
+			int begin = member * chunk;
+			int end = begin + chunk < count ? begin + chunk : count;
+			if( begin < end ) {
+				pWork( begin, end, member );
+			}
+		} );
+	}
+}
 
-	for (int i = 0; i < m_count; i++) {
-		if (m_pNodes[i] != goal) {
-			sf::Vector2f startPoint = sf::Vector2f(m_pNodes[i]->getX(), m_pNodes[i]->getY());
-			sf::Vector2f end = sf::Vector2f(goal->getX(), goal->getY());
-			int realWeight = (int)(sqrt((pow(end.x - startPoint.x, 2)) + (pow(end.y - startPoint.y, 2))));
-			m_pNodes[i]->setHeuristic(realWeight);
-			//UCS(m_pNodes[i], goal);
+// ----------------------------------------------------------------
+//  Name:           deltaStepping
+//  Description:    Parallel one-to-all shortest paths. Nodes are kept
+//                  in buckets of width delta; the arcs of each bucket
+//                  are scanned by every thread at once, light arcs
+//                  (weight <= delta) until the bucket stops changing,
+//                  then heavy arcs once.
+//
+//                  Each thread owns a contiguous block of nodes, with
+//                  their distances and their share of every bucket.
+//                  A relaxation found while scanning is sent to the
+//                  owner of the arc's target, and each owner applies
+//                  the ones sent to it, so both halves of a phase run
+//                  on every thread and no two threads ever write the
+//                  same node. The threads are started once and reused
+//                  for every phase.
+//
+//                  Distances match a sequential UCS. Of several
+//                  parents at the same distance the lowest index is
+//                  kept, but only over arcs of positive weight: a
+//                  parent is then always strictly nearer the source,
+//                  so zero weight arcs can't link two nodes as each
+//                  other's previous. Unlike UCS, the nodes themselves
+//                  are left untouched.
+//  Arguments:      The first parameter is the source node.
+//                  The second parameter is the bucket width.
+//                  The third parameter is filled with the distance of
+//                  every node (numeric max if unreachable).
+//                  The fourth parameter is filled with the index of the
+//                  previous node on the path (-1 for none).
+//                  Both arrays must hold the maximum number of nodes.
+//                  The fifth parameter is the thread count, 0 uses
+//                  every core.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::deltaStepping( Node* pNode, ArcType delta, ArcType* distance, int* previous, int threads ) {
+	// a relaxation found by a worker: (node, distance, previous), and
+	// whether it came over an arc of positive weight.
+	struct Request {
+		int node;
+		ArcType distance;
+		int previous;
+		bool positive;
+	};
+
+	const ArcType infinity = numeric_limits<ArcType>::max();
+	for( int i = 0; i < m_maxNodes; i++ ) {
+		distance[i] = infinity;
+		previous[i] = -1;
+	}
+	if( pNode == 0 ) {
+		return;
+	}
+	if( delta <= ArcType(0) ) {
+		delta = ArcType(1);
+	}
+
+	WorkerTeam team( threads );
+	threads = team.size();
+	// nodes [owner * span, (owner + 1) * span) belong to each owner.
+	int span = (m_maxNodes + threads - 1) / threads;
+
+	// every owner's buckets, frontier and settled nodes, and the
+	// relaxations each owner has found for each other owner.
+	vector< vector< vector<int> > > buckets( threads );
+	vector< vector<int> > frontier( threads );
+	vector< vector<int> > settled( threads );
+	vector< vector< vector<Request> > > requests( threads, vector< vector<Request> >( threads ) );
+	// flags are a byte per node so owners never share a word.
+	vector<char> queued( m_maxNodes, 0 );
+	vector<char> inSettled( m_maxNodes, 0 );
+
+	int source = pNode->getIndex();
+	distance[source] = ArcType(0);
+	buckets[source / span].push_back( vector<int>( 1, source ) );
+
+	// collect the relaxations of light or heavy arcs out of each
+	// owner's nodes, addressed to the owners of their targets.
+	auto scan = [&]( vector< vector<int> >& nodes, bool light ) {
+		team.run( [&]( int owner ) {
+			vector< vector<Request> >& out = requests[owner];
+			for( size_t i = 0; i < nodes[owner].size(); i++ ) {
+				int from = nodes[owner][i];
+				typename list<Arc>::const_iterator iter = m_pNodes[from]->arcList().begin();
+				typename list<Arc>::const_iterator endIter = m_pNodes[from]->arcList().end();
+				for( ; iter != endIter; ++iter ) {
+					if( ((*iter).weight() <= delta) == light ) {
+						int to = (*iter).node()->getIndex();
+						Request r = { to, distance[from] + (*iter).weight(), from, (*iter).weight() > ArcType(0) };
+						out[to / span].push_back( r );
+					}
+				}
+			}
+		} );
+	};
+
+	// every owner applies the relaxations sent to it, moving improved
+	// nodes between its own buckets.
+	auto relax = [&]() {
+		team.run( [&]( int owner ) {
+			vector< vector<int> >& ownBuckets = buckets[owner];
+			for( int t = 0; t < threads; t++ ) {
+				vector<Request>& in = requests[t][owner];
+				for( size_t i = 0; i < in.size(); i++ ) {
+					const Request& r = in[i];
+					if( r.distance < distance[r.node] ) {
+						distance[r.node] = r.distance;
+						previous[r.node] = r.previous;
+						size_t bucket = (size_t)(r.distance / delta);
+						if( bucket >= ownBuckets.size() ) {
+							ownBuckets.resize( bucket + 1 );
+						}
+						ownBuckets[bucket].push_back( r.node );
+					}
+					else if( r.distance == distance[r.node] && r.positive == true && r.previous < previous[r.node] ) {
+						previous[r.node] = r.previous;
+					}
+				}
+				in.clear();
+			}
+		} );
+	};
+
+	for( size_t current = 0; ; current++ ) {
+		// stop once no owner has a bucket this far up.
+		bool more = false;
+		for( int t = 0; t < threads; t++ ) {
+			more = more || current < buckets[t].size();
+		}
+		if( more == false ) {
+			break;
+		}
+
+		for( ;; ) {
+			// each owner takes its part of the current bucket, dropping
+			// stale entries that have since moved to a lower distance
+			// and duplicates already queued in this phase.
+			bool empty = true;
+			for( int t = 0; t < threads; t++ ) {
+				empty = empty && (current >= buckets[t].size() || buckets[t][current].size() == 0);
+			}
+			if( empty == true ) {
+				break;
+			}
+			team.run( [&]( int owner ) {
+				vector<int>& nodes = frontier[owner];
+				nodes.clear();
+				if( current < buckets[owner].size() ) {
+					nodes.swap( buckets[owner][current] );
+				}
+				size_t kept = 0;
+				for( size_t i = 0; i < nodes.size(); i++ ) {
+					int node = nodes[i];
+					if( (size_t)(distance[node] / delta) == current && queued[node] == 0 ) {
+						queued[node] = 1;
+						nodes[kept++] = node;
+					}
+				}
+				nodes.resize( kept );
+				for( size_t i = 0; i < nodes.size(); i++ ) {
+					queued[nodes[i]] = 0;
+					if( inSettled[nodes[i]] == 0 ) {
+						inSettled[nodes[i]] = 1;
+						settled[owner].push_back( nodes[i] );
+					}
+				}
+			} );
+			scan( frontier, true );
+			relax();
+		}
+		// heavy arcs can never land back in the current bucket.
+		scan( settled, false );
+		relax();
+		for( int t = 0; t < threads; t++ ) {
+			for( size_t i = 0; i < settled[t].size(); i++ ) {
+				inSettled[settled[t][i]] = 0;
+			}
+			settled[t].clear();
 		}
-		resetNodes();
 	}
+}
 
-	start->data().second = 0;
-	nodeQueue.push( start );
-	nodeQueue.top()->setMarked(true);
+// ----------------------------------------------------------------
+//  Name:           reverseArcs
+//  Description:    Builds the incoming arcs of every node in one flat
+//                  array. The arcs into node i are stored between
+//                  offsets[i] and offsets[i + 1].
+//  Arguments:      The first parameter is filled with the offsets
+//                  (maximum number of nodes + 1 entries).
+//                  The second parameter is filled with the index of
+//                  the node each arc comes from.
+//                  The third parameter is filled with the arc weights.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::reverseArcs( vector<int>& offsets, vector<int>& sources, vector<ArcType>& weights ) {
+	offsets.assign( m_maxNodes + 1, 0 );
+	// count the arcs into each node.
+	for( int i = 0; i < m_maxNodes; i++ ) {
+		if( m_pNodes[i] != 0 ) {
+			typename list<Arc>::const_iterator iter = m_pNodes[i]->arcList().begin();
+			typename list<Arc>::const_iterator endIter = m_pNodes[i]->arcList().end();
+			for( ; iter != endIter; ++iter ) {
+				offsets[(*iter).node()->getIndex() + 1]++;
+			}
+		}
+	}
+	for( int i = 0; i < m_maxNodes; i++ ) {
+		offsets[i + 1] += offsets[i];
+	}
 
-	while (nodeQueue.size() != 0 && nodeQueue.top() != goal) {
-		list<Arc>::const_iterator iter = nodeQueue.top()->arcList().begin();
-		list<Arc>::const_iterator endIter = nodeQueue.top()->arcList().end();
+	// then drop each arc into its slot.
+	vector<int> next( offsets.begin(), offsets.end() - 1 );
+	sources.resize( offsets[m_maxNodes] );
+	weights.resize( offsets[m_maxNodes] );
+	for( int i = 0; i < m_maxNodes; i++ ) {
+		if( m_pNodes[i] != 0 ) {
+			typename list<Arc>::const_iterator iter = m_pNodes[i]->arcList().begin();
+			typename list<Arc>::const_iterator endIter = m_pNodes[i]->arcList().end();
+			for( ; iter != endIter; ++iter ) {
+				int slot = next[(*iter).node()->getIndex()]++;
+				sources[slot] = i;
+				weights[slot] = (*iter).weight();
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           parallelBreadthFirst
+//  Description:    Level-synchronous breadth-first traversal spread
+//                  across threads. Small frontiers are expanded top
+//                  down along outgoing arcs; once the frontier touches
+//                  a large share of the remaining arcs, the unvisited
+//                  nodes instead look bottom up along incoming arcs for
+//                  a parent in the frontier. Visited nodes are claimed
+//                  through an atomic bitmap so the node marks are left
+//                  alone and other searches can share the graph.
+//  Arguments:      The first parameter is the starting node.
+//                  The second parameter is filled with the hop count
+//                  of every node (-1 if unreachable).
+//                  The third parameter is filled with the index of the
+//                  node it was reached from (-1 for none).
+//                  Both arrays must hold the maximum number of nodes.
+//                  The fourth parameter is the thread count, 0 uses
+//                  every core.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::parallelBreadthFirst( Node* pNode, int* hops, int* previous, int threads ) {
+	// switch thresholds from Beamer et al.
+	const int alpha = 14;
+	const int beta = 24;
+
+	for( int i = 0; i < m_maxNodes; i++ ) {
+		hops[i] = -1;
+		previous[i] = -1;
+	}
+	if( pNode == 0 ) {
+		return;
+	}
+	WorkerTeam team( threads );
+	threads = team.size();
+
+	int words = (m_maxNodes + 31) / 32;
+	std::atomic<unsigned int>* visited = new std::atomic<unsigned int>[words];
+	for( int i = 0; i < words; i++ ) {
+		visited[i] = 0;
+	}
+
+	vector<int> offsets;
+	vector<int> sources;
+	vector<ArcType> weights;
+	bool haveReverse = false;
+
+	long long unexploredArcs = 0;
+	for( int i = 0; i < m_maxNodes; i++ ) {
+		if( m_pNodes[i] != 0 ) {
+			unexploredArcs += m_pNodes[i]->arcList().size();
+		}
+	}
+
+	vector<int> frontier( 1, pNode->getIndex() );
+	vector<char> inFrontier( m_maxNodes, 0 );
+	vector< vector<int> > next( threads );
+	int level = 0;
+	bool bottomUp = false;
+
+	visited[pNode->getIndex() / 32] |= 1u << (pNode->getIndex() % 32);
+	hops[pNode->getIndex()] = 0;
+
+	while( frontier.size() != 0 ) {
+		long long frontierArcs = 0;
+		for( size_t i = 0; i < frontier.size(); i++ ) {
+			frontierArcs += m_pNodes[frontier[i]]->arcList().size();
+		}
+		unexploredArcs -= frontierArcs;
+
+		// pick the direction for this level.
+		if( bottomUp == false && frontierArcs > unexploredArcs / alpha ) {
+			bottomUp = true;
+		}
+		else if( bottomUp == true && (long long)frontier.size() < m_count / beta ) {
+			bottomUp = false;
+		}
 
-		for( ; iter != endIter; iter++ ) {
-			if ((*iter).node() != nodeQueue.top()->getPrevious() && (*iter).node()->marked() != true) {
-				int distanceChild = nodeQueue.top()->data().second + (*iter).weight();// + (*iter).node()->getHeuristic();
-				int estTotalCost = (*iter).node()->data().second;
-				(*iter).node()->setColor(2);
-				estTotalCost = abs(estTotalCost);
-				if (distanceChild < estTotalCost) {
-					(*iter).node()->data().second = distanceChild;
-					(*iter).node()->setPrevious(nodeQueue.top());
+		if( bottomUp == false ) {
+			parallelFor( team, (int)frontier.size(), [&]( int begin, int end, int thread ) {
+				for( int i = begin; i < end; i++ ) {
+					int from = frontier[i];
+					typename list<Arc>::const_iterator iter = m_pNodes[from]->arcList().begin();
+					typename list<Arc>::const_iterator endIter = m_pNodes[from]->arcList().end();
+					for( ; iter != endIter; ++iter ) {
+						int to = (*iter).node()->getIndex();
+						unsigned int bit = 1u << (to % 32);
+						// only the thread that sets the bit claims the node.
+						if( (visited[to / 32].load() & bit) == 0 && (visited[to / 32].fetch_or( bit ) & bit) == 0 ) {
+							hops[to] = level + 1;
+							previous[to] = from;
+							next[thread].push_back( to );
+						}
+					}
 				}
-				if ( (*iter).node()->marked() == false) {
-					nodeQueue.push( (*iter).node() );
-					(*iter).node()->setMarked(true);
+			} );
+		}
+		else {
+			if( haveReverse == false ) {
+				reverseArcs( offsets, sources, weights );
+				haveReverse = true;
+			}
+			for( size_t i = 0; i < frontier.size(); i++ ) {
+				inFrontier[frontier[i]] = 1;
+			}
+			parallelFor( team, m_maxNodes, [&]( int begin, int end, int thread ) {
+				for( int to = begin; to < end; to++ ) {
+					if( m_pNodes[to] != 0 && (visited[to / 32].load() & (1u << (to % 32))) == 0 ) {
+						for( int slot = offsets[to]; slot < offsets[to + 1]; slot++ ) {
+							if( inFrontier[sources[slot]] != 0 ) {
+								visited[to / 32].fetch_or( 1u << (to % 32) );
+								hops[to] = level + 1;
+								previous[to] = sources[slot];
+								next[thread].push_back( to );
+								break;
+							}
+						}
+					}
 				}
+			} );
+			for( size_t i = 0; i < frontier.size(); i++ ) {
+				inFrontier[frontier[i]] = 0;
 			}
+		}
 
+		// gather the next level from every thread.
+		frontier.clear();
+		for( int t = 0; t < threads; t++ ) {
+			frontier.insert( frontier.end(), next[t].begin(), next[t].end() );
+			next[t].clear();
 		}
-		nodeQueue.pop();
+		level++;
 	}
-	if (nodeQueue.size() != 0) {
-		search = false;
-		foundNode = nodeQueue.top();
-		foundNode->setColor(1);
-		pathCost = foundNode->data().second;
-		cout << "The fastest route to: " << foundNode->data().first << endl;
-		path.push_back(foundNode); //final node, the node that the path is to.
-		while (foundNode->getPrevious() != NULL) {
-			path.push_back(foundNode->getPrevious());
-			cout << "-> " << foundNode->getPrevious()->data().first << endl;
-			foundNode = foundNode->getPrevious();
-			if (foundNode->getColor() != 3)
-				foundNode->setColor(1);
+
+	delete [] visited;
+}
+
+// ----------------------------------------------------------------
+//  Name:           buildComponents
+//  Description:    Builds the connectivity index used by reachable.
+//                  Arcs added afterwards keep it up to date; removing
+//                  arcs or nodes rebuilds it on the next query.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::buildComponents() {
+	buildWeakComponents();
+	buildStrongComponents();
+}
+
+// ----------------------------------------------------------------
+//  Name:           buildWeakComponents
+//  Description:    Labels the components of the graph with the arc
+//                  directions ignored.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::buildWeakComponents() {
+	vector<int> offsets;
+	vector<int> sources;
+	vector<ArcType> weights;
+	reverseArcs( offsets, sources, weights );
+
+	m_weakComponent.assign( m_maxNodes, -1 );
+	m_weakMembers.clear();
+
+	vector<int> nodeStack;
+	for( int i = 0; i < m_maxNodes; i++ ) {
+		if( m_pNodes[i] != 0 && m_weakComponent[i] == -1 ) {
+			int component = (int)m_weakMembers.size();
+			m_weakMembers.push_back( vector<int>() );
+			m_weakComponent[i] = component;
+			nodeStack.push_back( i );
+
+			// flood the component along arcs in both directions.
+			while( nodeStack.size() != 0 ) {
+				int node = nodeStack.back();
+				nodeStack.pop_back();
+				m_weakMembers[component].push_back( node );
+
+				typename list<Arc>::const_iterator iter = m_pNodes[node]->arcList().begin();
+				typename list<Arc>::const_iterator endIter = m_pNodes[node]->arcList().end();
+				for( ; iter != endIter; ++iter ) {
+					int to = (*iter).node()->getIndex();
+					if( m_weakComponent[to] == -1 ) {
+						m_weakComponent[to] = component;
+						nodeStack.push_back( to );
+					}
+				}
+				for( int slot = offsets[node]; slot < offsets[node + 1]; slot++ ) {
+					if( m_weakComponent[sources[slot]] == -1 ) {
+						m_weakComponent[sources[slot]] = component;
+						nodeStack.push_back( sources[slot] );
+					}
+				}
+			}
+		}
+	}
+	m_weakValid = true;
+}
+
+// ----------------------------------------------------------------
+//  Name:           buildStrongComponents
+//  Description:    Labels the strongly connected components with
+//                  Tarjan's algorithm, using an explicit stack in
+//                  place of recursion so long chains cannot overflow.
+//                  Components are numbered as they are completed,
+//                  which is reverse topological order.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::buildStrongComponents() {
+	// a node being explored and the next arc to follow from it.
+	struct Frame {
+		int node;
+		typename list<Arc>::const_iterator iter;
+	};
+
+	vector<int> order( m_maxNodes, -1 );
+	vector<int> low( m_maxNodes, 0 );
+	vector<bool> onStack( m_maxNodes, false );
+	vector<int> componentStack;
+	vector<Frame> callStack;
+	int counter = 0;
+
+	m_strongComponent.assign( m_maxNodes, -1 );
+	m_strongCount = 0;
+
+	for( int root = 0; root < m_maxNodes; root++ ) {
+		if( m_pNodes[root] == 0 || order[root] != -1 ) {
+			continue;
+		}
+		Frame first = { root, m_pNodes[root]->arcList().begin() };
+		callStack.push_back( first );
+		order[root] = low[root] = counter++;
+		componentStack.push_back( root );
+		onStack[root] = true;
+
+		while( callStack.size() != 0 ) {
+			Frame& frame = callStack.back();
+			int node = frame.node;
+
+			if( frame.iter != m_pNodes[node]->arcList().end() ) {
+				int to = (*frame.iter).node()->getIndex();
+				++frame.iter;
+				if( order[to] == -1 ) {
+					// descend into the child.
+					order[to] = low[to] = counter++;
+					componentStack.push_back( to );
+					onStack[to] = true;
+					Frame child = { to, m_pNodes[to]->arcList().begin() };
+					callStack.push_back( child );
+				}
+				else if( onStack[to] == true && order[to] < low[node] ) {
+					low[node] = order[to];
+				}
+			}
+			else {
+				// every arc is done, so close the component if this is its root.
+				if( low[node] == order[node] ) {
+					int member;
+					do {
+						member = componentStack.back();
+						componentStack.pop_back();
+						onStack[member] = false;
+						m_strongComponent[member] = m_strongCount;
+					} while( member != node );
+					m_strongCount++;
+				}
+				callStack.pop_back();
+				if( callStack.size() != 0 && low[node] < low[callStack.back().node] ) {
+					low[callStack.back().node] = low[node];
+				}
+			}
+		}
+	}
+	m_strongValid = true;
+}
+
+// ----------------------------------------------------------------
+//  Name:           reachable
+//  Description:    Constant time check (once the index is built, see
+//                  buildComponents) that a path may exist. Nodes
+//                  in different weak components, or whose strong
+//                  components are in the wrong topological order,
+//                  can never be joined by a path.
+//  Arguments:      The first parameter is the start node.
+//                  The second parameter is the goal node.
+//  Return Value:   false if there is definitely no path.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+bool Graph<NodeType, ArcType>::reachable( Node* from, Node* to ) {
+	if( m_weakValid == false ) {
+		buildWeakComponents();
+	}
+	if( m_strongValid == false ) {
+		buildStrongComponents();
+	}
+
+	return m_weakComponent[from->getIndex()] == m_weakComponent[to->getIndex()] &&
+		m_strongComponent[from->getIndex()] >= m_strongComponent[to->getIndex()];
+}
+
+// ----------------------------------------------------------------
+//  Name:           componentLabels
+//  Description:    Copies out the connectivity index, so it can be
+//                  saved and restored with setComponentLabels instead
+//                  of being rebuilt.
+//  Arguments:      The first parameter gets each node's weak
+//                  component, -1 for no node.
+//                  The second parameter gets each node's strong
+//                  component.
+//  Return Value:   false if the index isn't built or is out of date.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+bool Graph<NodeType, ArcType>::componentLabels( vector<int>& weak, vector<int>& strong ) const {
+	if( m_weakValid == false || m_strongValid == false ) {
+		return false;
+	}
+	weak = m_weakComponent;
+	strong = m_strongComponent;
+	return true;
+}
+
+// ----------------------------------------------------------------
+//  Name:           setComponentLabels
+//  Description:    Restores a connectivity index saved from this same
+//                  graph by componentLabels. Arcs added afterwards
+//                  keep it up to date as usual.
+//  Arguments:      The first parameter is each node's weak component.
+//                  The second parameter is each node's strong
+//                  component.
+//                  The third parameter is the number of labels in
+//                  each, which must be maxSize().
+//  Return Value:   false if the labels don't fit this graph.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+bool Graph<NodeType, ArcType>::setComponentLabels( const int* weak, const int* strong, int count ) {
+	if( count != m_maxNodes ) {
+		return false;
+	}
+	int weakCount = 0;
+	int strongCount = 0;
+	for( int i = 0; i < count; i++ ) {
+		if( (m_pNodes[i] == 0) != (weak[i] < 0) || weak[i] >= count || strong[i] >= count ) {
+			return false;
+		}
+		weakCount = max( weakCount, weak[i] + 1 );
+		strongCount = max( strongCount, strong[i] + 1 );
+	}
+
+	m_weakComponent.assign( weak, weak + count );
+	m_strongComponent.assign( strong, strong + count );
+	m_weakMembers.assign( weakCount, vector<int>() );
+	for( int i = 0; i < count; i++ ) {
+		if( weak[i] >= 0 ) {
+			m_weakMembers[weak[i]].push_back( i );
+		}
+	}
+	m_strongCount = strongCount;
+	m_weakValid = true;
+	m_strongValid = true;
+	return true;
+}
+
+// ----------------------------------------------------------------
+//  Name:           hilbertIndex
+//  Description:    Distance along a 2^16 x 2^16 Hilbert curve.
+//  Arguments:      The x and y position on the curve.
+//  Return Value:   The distance along the curve.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+unsigned long long Graph<NodeType, ArcType>::hilbertIndex( unsigned int x, unsigned int y ) {
+	const unsigned int n = 1u << 16;
+	unsigned long long distance = 0;
+	for( unsigned int half = n / 2; half > 0; half /= 2 ) {
+		unsigned int rx = (x & half) > 0 ? 1 : 0;
+		unsigned int ry = (y & half) > 0 ? 1 : 0;
+		distance += (unsigned long long)half * half * ((3 * rx) ^ ry);
+		// rotate the quadrant so the curve stays continuous.
+		if( ry == 0 ) {
+			if( rx == 1 ) {
+				x = n - 1 - x;
+				y = n - 1 - y;
+			}
+			std::swap( x, y );
+		}
+	}
+	return distance;
+}
+
+// ----------------------------------------------------------------
+//  Name:           breadthFirstOrder
+//  Description:    Lists every node in breadth-first order, starting
+//                  a new traversal from the lowest unlisted index
+//                  whenever one runs out. With byDegree the start is
+//                  the lowest degree node and linked nodes are queued
+//                  in order of degree (Cuthill-McKee).
+//  Arguments:      The first parameter is filled with the indices.
+//                  The second parameter selects Cuthill-McKee.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::breadthFirstOrder( vector<int>& order, bool byDegree ) {
+	vector<bool> listed( m_maxNodes, false );
+	vector< pair<int, int> > children;
+	vector<int> roots;
+	for( int i = 0; i < m_maxNodes; i++ ) {
+		if( m_pNodes[i] != 0 ) {
+			roots.push_back( i );
+		}
+	}
+	if( byDegree == true ) {
+		stable_sort( roots.begin(), roots.end(), [this]( int a, int b ) {
+			return m_pNodes[a]->arcList().size() < m_pNodes[b]->arcList().size();
+		} );
+	}
+
+	order.clear();
+	for( size_t r = 0; r < roots.size(); r++ ) {
+		if( listed[roots[r]] == true ) {
+			continue;
+		}
+		// the order list doubles as the queue.
+		size_t head = order.size();
+		order.push_back( roots[r] );
+		listed[roots[r]] = true;
+		while( head < order.size() ) {
+			Node* pNode = m_pNodes[order[head++]];
+			children.clear();
+			typename list<Arc>::const_iterator iter = pNode->arcList().begin();
+			typename list<Arc>::const_iterator endIter = pNode->arcList().end();
+			for( ; iter != endIter; ++iter ) {
+				int to = (*iter).node()->getIndex();
+				if( listed[to] == false ) {
+					listed[to] = true;
+					children.push_back( make_pair( byDegree ? (int)(*iter).node()->arcList().size() : 0, to ) );
+				}
+			}
+			stable_sort( children.begin(), children.end(), []( const pair<int, int>& a, const pair<int, int>& b ) {
+				return a.first < b.first;
+			} );
+			for( size_t i = 0; i < children.size(); i++ ) {
+				order.push_back( children[i].second );
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           reorder
+//  Description:    Renumbers the nodes so that nodes used together
+//                  get nearby indices, and sorts each arc list by
+//                  target index. Arrays indexed by node, such as the
+//                  search state and the compressed graph, then keep
+//                  neighbours close together. The node objects are
+//                  still allocated one by one; they are rebuilt in
+//                  the new order, which most allocators lay out close
+//                  together, but nothing guarantees it. Data,
+//                  positions, marks and heuristics carry over; use
+//                  externalIndex and internalIndex to translate the
+//                  old indices. SearchChecks' --reorder-bench times
+//                  queries before and after each ordering.
+//  Arguments:      The ordering to use.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::reorder( Ordering ordering ) {
+	// order[new index] = current index.
+	vector<int> order;
+	if( ordering == HILBERT_ORDER ) {
+		int minX = INT_MAX, minY = INT_MAX, maxX = INT_MIN, maxY = INT_MIN;
+		for( int i = 0; i < m_maxNodes; i++ ) {
+			if( m_pNodes[i] != 0 ) {
+				order.push_back( i );
+				minX = min( minX, m_pNodes[i]->getX() );
+				minY = min( minY, m_pNodes[i]->getY() );
+				maxX = max( maxX, m_pNodes[i]->getX() );
+				maxY = max( maxY, m_pNodes[i]->getY() );
+			}
+		}
+		// scale the positions onto the curve's grid.
+		double scale = 65535.0 / max( 1.0, (double)max( maxX - minX, maxY - minY ) );
+		vector<unsigned long long> keys( m_maxNodes, 0 );
+		for( size_t i = 0; i < order.size(); i++ ) {
+			Node* pNode = m_pNodes[order[i]];
+			keys[order[i]] = hilbertIndex( (unsigned int)((pNode->getX() - minX) * scale), (unsigned int)((pNode->getY() - minY) * scale) );
+		}
+		stable_sort( order.begin(), order.end(), [&keys]( int a, int b ) {
+			return keys[a] < keys[b];
+		} );
+	}
+	else {
+		breadthFirstOrder( order, ordering == RCM_ORDER );
+		if( ordering == RCM_ORDER ) {
+			reverse( order.begin(), order.end() );
 		}
+	}
 
-		/*for (int i = path.size() - 1; i >= 0; i--) {
+	vector<int> newIndex( m_maxNodes, -1 );
+	for( size_t i = 0; i < order.size(); i++ ) {
+		newIndex[order[i]] = (int)i;
+	}
 
-		}*/
+	// rebuild the nodes in their new order.
+	Node** pNodes = new Node * [m_maxNodes];
+	for( int i = 0; i < m_maxNodes; i++ ) {
+		pNodes[i] = 0;
+	}
+	for( size_t i = 0; i < order.size(); i++ ) {
+		Node* pOld = m_pNodes[order[i]];
+		Node* pNew = new Node();
+		pNew->setData( pOld->data() );
+		pNew->setMarked( pOld->marked() );
+		pNew->setPosition( make_pair( pOld->getX(), pOld->getY() ) );
+		pNew->setHeuristic( pOld->getHeuristic() );
+		pNew->setColor( pOld->getColor() );
+		pNew->setCategory( pOld->getCategory() );
+		pNew->setIndex( (int)i );
+		pNew->trackColor( &m_colorChanges );
+		pNodes[i] = pNew;
+	}
+
+	vector< pair<int, ArcType> > arcs;
+	for( size_t i = 0; i < order.size(); i++ ) {
+		Node* pOld = m_pNodes[order[i]];
+		if( pOld->getPrevious() != NULL ) {
+			pNodes[i]->setPrevious( pNodes[newIndex[pOld->getPrevious()->getIndex()]] );
+		}
+		arcs.clear();
+		typename list<Arc>::const_iterator iter = pOld->arcList().begin();
+		typename list<Arc>::const_iterator endIter = pOld->arcList().end();
+		for( ; iter != endIter; ++iter ) {
+			arcs.push_back( make_pair( newIndex[(*iter).node()->getIndex()], (*iter).weight() ) );
+		}
+		stable_sort( arcs.begin(), arcs.end(), []( const pair<int, ArcType>& a, const pair<int, ArcType>& b ) {
+			return a.first < b.first;
+		} );
+		for( size_t a = 0; a < arcs.size(); a++ ) {
+			pNodes[i]->addArc( pNodes[arcs[a].first], arcs[a].second );
+		}
+	}
+
+	// update the id maps; empty slots keep the unused ids.
+	vector<int> externalIds( m_maxNodes, -1 );
+	vector<bool> used( m_maxNodes, false );
+	for( size_t i = 0; i < order.size(); i++ ) {
+		externalIds[i] = externalIndex( order[i] );
+		used[externalIds[i]] = true;
+	}
+	int freeId = 0;
+	for( int i = (int)order.size(); i < m_maxNodes; i++ ) {
+		while( used[freeId] == true ) {
+			freeId++;
+		}
+		externalIds[i] = freeId++;
+	}
+	m_externalIds.swap( externalIds );
+	m_internalIds.assign( m_maxNodes, -1 );
+	for( int i = 0; i < m_maxNodes; i++ ) {
+		m_internalIds[m_externalIds[i]] = i;
+	}
+
+	for( int i = 0; i < m_maxNodes; i++ ) {
+		if( m_pNodes[i] != 0 ) {
+			delete m_pNodes[i];
+		}
+	}
+	delete [] m_pNodes;
+	m_pNodes = pNodes;
+	m_version++;
+	m_spatialValid = false;
+	m_hovered = -1;
+	// the old indices mean nothing now; views are rebuilt anyway.
+	m_colorChanges.clear();
+
+	for( typename map< int, vector<int> >::iterator iter = m_categories.begin(); iter != m_categories.end(); ++iter ) {
+		for( size_t i = 0; i < iter->second.size(); i++ ) {
+			iter->second[i] = newIndex[iter->second[i]];
+		}
+	}
+
+	m_weakValid = false;
+	m_strongValid = false;
+}
+
+// ----------------------------------------------------------------
+//  Name:           estimate
+//  Description:    Heuristic cost between two nodes: the straight
+//                  line distance between them, scaled to 90% (as UCS
+//                  does) so rounding in the arc weights never makes
+//                  it overestimate.
+//  Arguments:      The first parameter is the node to estimate from.
+//                  The second parameter is the node to estimate to.
+//  Return Value:   The estimated cost.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+ArcType Graph<NodeType, ArcType>::estimate( Node* from, Node* to ) const {
+	double dx = to->getX() - from->getX();
+	double dy = to->getY() - from->getY();
+	return (ArcType)((sqrt( dx * dx + dy * dy ) * 90) / 100);
+}
+
+// ----------------------------------------------------------------
+//  Name:           setCategory
+//  Description:    Puts a node in a category (such as depots), or
+//                  takes it out of any category with -1.
+//  Arguments:      The first parameter is the node index.
+//                  The second parameter is the category.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::setCategory( int index, int category ) {
+	int old = m_pNodes[index]->getCategory();
+	if( old == category ) {
+		return;
+	}
+	if( old != -1 ) {
+		vector<int>& members = m_categories[old];
+		members.erase( find( members.begin(), members.end(), index ) );
+		if( members.size() == 0 ) {
+			m_categories.erase( old );
+		}
+	}
+	if( category != -1 ) {
+		m_categories[category].push_back( index );
+	}
+	m_pNodes[index]->setCategory( category );
+}
+
+// ----------------------------------------------------------------
+//  Name:           buildCategories
+//  Description:    Sets the category of every node from its data.
+//  Arguments:      A function taking the node data and returning
+//                  its category (-1 for none).
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+template<class Classify>
+void Graph<NodeType, ArcType>::buildCategories( Classify pClassify ) {
+	for( int i = 0; i < m_maxNodes; i++ ) {
+		if( m_pNodes[i] != 0 ) {
+			setCategory( i, pClassify( m_pNodes[i]->data() ) );
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           categoryMembers
+//  Description:    Looks up the nodes in a category.
+//  Arguments:      The category.
+//  Return Value:   The node indices, empty if there are none.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+const vector<int>& Graph<NodeType, ArcType>::categoryMembers( int category ) {
+	static const vector<int> none;
+	typename map< int, vector<int> >::const_iterator iter = m_categories.find( category );
+	return iter == m_categories.end() ? none : iter->second;
+}
+
+// ----------------------------------------------------------------
+//  Name:           nearestInCategory
+//  Description:    Finds the cheapest nodes of a category to reach
+//                  from a node, by arc weight. The search stops as
+//                  soon as enough targets are settled, or every node
+//                  in the category has been found. Costs are kept in
+//                  the caller's search state, so a query only touches
+//                  the nodes it reaches and nothing is allocated once
+//                  the state has grown to the graph's size.
+//  Arguments:      The first parameter is the starting node.
+//                  The second parameter is the category to look for.
+//                  The third parameter is how many targets to find.
+//                  The fourth parameter is filled with the target
+//                  indices and their path costs, cheapest first.
+//                  The fifth parameter is scratch space to reuse.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::nearestInCategory( Node* pNode, int category, int count, vector< pair<int, ArcType> >& found, SearchState<ArcType>& state ) {
+	typedef pair<ArcType, int> Entry;
+	greater<Entry> compare;
+	found.clear();
+
+	int targets = (int)categoryMembers( category ).size();
+	if( pNode == 0 || targets == 0 || count <= 0 ) {
+		return;
+	}
+	if( count > targets ) {
+		count = targets;
+	}
+
+	state.begin( m_maxNodes );
+	state.reach( pNode->getIndex(), 0, -1 );
+	state.open.push_back( Entry( 0, pNode->getIndex() ) );
+
+	while( state.open.size() != 0 && (int)found.size() < count ) {
+		pop_heap( state.open.begin(), state.open.end(), compare );
+		Entry top = state.open.back();
+		state.open.pop_back();
+		if( state.closed( top.second ) == true ) {
+			continue;
+		}
+		state.close( top.second );
+		if( m_pNodes[top.second]->getCategory() == category ) {
+			found.push_back( make_pair( top.second, top.first ) );
+		}
+
+		typename list<Arc>::const_iterator iter = m_pNodes[top.second]->arcList().begin();
+		typename list<Arc>::const_iterator endIter = m_pNodes[top.second]->arcList().end();
+		for( ; iter != endIter; ++iter ) {
+			int to = (*iter).node()->getIndex();
+			ArcType distance = top.first + (*iter).weight();
+			if( state.closed( to ) == false && distance < state.cost( to ) ) {
+				state.reach( to, distance, top.second );
+				state.open.push_back( Entry( distance, to ) );
+				push_heap( state.open.begin(), state.open.end(), compare );
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           nearestInCategory
+//  Description:    Finds the cheapest nodes of a category, using its
+//                  own scratch space. Callers that search repeatedly
+//                  should keep a SearchState and pass it in instead.
+//  Arguments:      As above, without the search state.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::nearestInCategory( Node* pNode, int category, int count, vector< pair<int, ArcType> >& found ) {
+	SearchState<ArcType> state;
+	nearestInCategory( pNode, category, count, found, state );
+}
+
+// ----------------------------------------------------------------
+//  Name:           assignNearest
+//  Description:    Finds the cheapest node of a category to reach
+//                  from every node, in one search that starts from
+//                  all of the category's nodes at once and follows
+//                  the arcs backwards.
+//  Arguments:      The first parameter is the category.
+//                  The second parameter is filled with each node's
+//                  cost to its nearest target (numeric max if none).
+//                  The third parameter is filled with the index of
+//                  that target (-1 for none).
+//                  Both arrays must hold the maximum number of nodes.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::assignNearest( int category, ArcType* distance, int* facility ) {
+	typedef pair<ArcType, int> Entry;
+	for( int i = 0; i < m_maxNodes; i++ ) {
+		distance[i] = numeric_limits<ArcType>::max();
+		facility[i] = -1;
+	}
+
+	const vector<int>& members = categoryMembers( category );
+	if( members.size() == 0 ) {
+		return;
+	}
+
+	vector<int> offsets;
+	vector<int> sources;
+	vector<ArcType> weights;
+	reverseArcs( offsets, sources, weights );
+
+	priority_queue< Entry, vector<Entry>, greater<Entry> > nodeQueue;
+	for( size_t i = 0; i < members.size(); i++ ) {
+		distance[members[i]] = 0;
+		facility[members[i]] = members[i];
+		nodeQueue.push( Entry( 0, members[i] ) );
+	}
+
+	while( nodeQueue.size() != 0 ) {
+		Entry top = nodeQueue.top();
+		nodeQueue.pop();
+		if( top.first > distance[top.second] ) {
+			continue;
+		}
+		// a node that leads here shares this node's facility.
+		for( int slot = offsets[top.second]; slot < offsets[top.second + 1]; slot++ ) {
+			int from = sources[slot];
+			if( top.first + weights[slot] < distance[from] ) {
+				distance[from] = top.first + weights[slot];
+				facility[from] = facility[top.second];
+				nodeQueue.push( Entry( distance[from], from ) );
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           knownUnreachable
+//  Description:    Like reachable, but never builds the index, so it
+//                  is safe to call from many threads at once.
+//  Arguments:      The first parameter is the start node index.
+//                  The second parameter is the goal node index.
+//  Return Value:   true only if the index is built and says there is
+//                  no path.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+bool Graph<NodeType, ArcType>::knownUnreachable( int from, int to ) const {
+	if( m_weakValid == false || m_strongValid == false ) {
+		return false;
+	}
+	return m_weakComponent[from] != m_weakComponent[to] ||
+		m_strongComponent[from] < m_strongComponent[to];
+}
+
+// ----------------------------------------------------------------
+//  Name:           boundedSearch
+//  Description:    A* search with limits. The search only reads the
+//                  graph and keeps its costs in the search state, so
+//                  any number of threads can search at once as long
+//                  as nobody changes the graph meanwhile. The deadline
+//                  and cancellation token are checked every
+//                  checkInterval expansions. If the search stops early
+//                  the path ends at the expanded node with the lowest
+//                  estimate to the goal. Nothing is allocated once the
+//                  state has grown to the graph's size; callers that
+//                  want the path copy it out with state.writePath.
+//  Arguments:      The first parameter is the start node index.
+//                  The second parameter is the goal node index.
+//                  The third parameter holds the limits.
+//                  The fourth parameter is scratch space to reuse.
+//  Return Value:   The outcome, cost and end of the path.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+QuerySummary<ArcType> Graph<NodeType, ArcType>::boundedSearch( int start, int goal, const QueryOptions& options, SearchState<ArcType>& state ) const {
+	if( knownUnreachable( start, goal ) == true ) {
+		return QuerySummary<ArcType>();
+	}
+
+	// the default engine, with its open list in the caller's state.
+	SearchEngine<Graph, ArcType> engine;
+	engine.openList().useStorage( state.open );
+	return engine.run( *this, start, goal, options, state );
+}
+
+// ----------------------------------------------------------------
+//  Name:           boundedSearch
+//  Description:    A* search with limits, run by an engine the caller
+//                  has put together, for another open list, heuristic
+//                  or search state. Queries between nodes known not to
+//                  connect return straight away, as above.
+//  Arguments:      The first parameter is the start node index.
+//                  The second parameter is the goal node index.
+//                  The third parameter holds the limits.
+//                  The fourth parameter is the engine's search state.
+//                  The fifth parameter is a SearchEngine over Graph.
+//  Return Value:   The outcome, cost and end of the path.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+template<class Engine, class State>
+QuerySummary<ArcType> Graph<NodeType, ArcType>::boundedSearch( int start, int goal, const QueryOptions& options, State& state, Engine& engine ) const {
+	if( knownUnreachable( start, goal ) == true ) {
+		return QuerySummary<ArcType>();
+	}
+	return engine.run( *this, start, goal, options, state );
+}
+
+// ----------------------------------------------------------------
+//  Name:           boundedSearch
+//  Description:    A* search with limits that also copies out the
+//                  path.
+//  Arguments:      The first parameter is the start node index.
+//                  The second parameter is the goal node index.
+//                  The third parameter holds the limits.
+//                  The fourth parameter is filled with the outcome.
+//                  The fifth parameter is scratch space to reuse.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::boundedSearch( int start, int goal, const QueryOptions& options, QueryResult<ArcType>& result, SearchState<ArcType>& state ) const {
+	QuerySummary<ArcType> summary = boundedSearch( start, goal, options, state );
+	result.status = summary.status;
+	result.cost = summary.cost;
+	result.expansions = summary.expansions;
+	state.writePath( summary.end, result.path );
+}
+
+// ----------------------------------------------------------------
+//  Name:           boundedSearch
+//  Description:    A* search with limits, using its own scratch space.
+//  Arguments:      The first parameter is the start node index.
+//                  The second parameter is the goal node index.
+//                  The third parameter holds the limits.
+//                  The fourth parameter is filled with the outcome.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::boundedSearch( int start, int goal, const QueryOptions& options, QueryResult<ArcType>& result ) const {
+	SearchState<ArcType> state;
+	boundedSearch( start, goal, options, result, state );
+}
+
+// ----------------------------------------------------------------
+//  Name:           AStar
+//  Description:    The viewer's search. Runs the search engine with
+//                  an observer that colours the nodes searched and
+//                  keeps their costs and estimates for the node info
+//                  panel, then colours the route found.
+//  Arguments:      The first parameter is the start node.
+//                  The second parameter is the goal node.
+//                  The third parameter is filled with the route, start
+//                  first.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void Graph<NodeType, ArcType>::AStar(Node* start, Node* goal, std::vector<Node*> &path ) {
+	typedef ViewerObserver<NodeType, ArcType> Observer;
+	typedef EuclideanHeuristic<Graph, ArcType> Heuristic;
+
+	path.clear();
+	// reject disconnected queries before any of the search is set up.
+	if (reachable(start, goal) == false) {
+		cout << "There is no path from node " << start->data().first << " to " << goal->data().first;
+		return;
+	}
+	resetNodes();
+
+	SearchEngine<Graph, ArcType, BinaryHeapOpenList<ArcType>, Heuristic, SearchState<ArcType>, Observer> engine( Heuristic(), Observer(*this) );
+	SearchState<ArcType> state;
+	QuerySummary<ArcType> result = engine.run(*this, start->getIndex(), goal->getIndex(), state);
+	if (result.status == QUERY_FOUND) {
+		search = false;
+		pathCost = result.cost;
+
+		vector<int> nodes;
+		state.writePath(result.end, nodes);
+		path.resize(nodes.size());
+		for (size_t i = 0; i < nodes.size(); i++)
+			path[i] = m_pNodes[nodes[i]];
+		engine.observer().showPath(nodes);
 	}
 	else
 		cout << "There is no path from node " << start->data().first << " to " << goal->data().first;
@@ -563,52 +2091,68 @@ void Graph<NodeType, ArcType>::resetNodes() {
 	}
 }
 
+#ifndef GRAPH_NO_SFML
 template<class NodeType, class ArcType>
 void Graph<NodeType, ArcType>::drawNodes(sf::RenderWindow window) {
 	for (int i = 0; i < m_count; i++) {
 		window.draw(m_pNodes[i]->getCircle());
 	}
 }
+#endif
+
+// ----------------------------------------------------------------
+//  Name:           spatialIndex
+//  Description:    Gets the k-d tree of node positions, rebuilding
+//                  it first if nodes have changed since.
+//  Arguments:      None.
+//  Return Value:   The spatial index.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+const SpatialIndex& Graph<NodeType, ArcType>::spatialIndex() {
+	if( m_spatialValid == false ) {
+		m_spatialIndex.build( *this );
+		m_spatialValid = true;
+	}
+	return m_spatialIndex;
+}
 
+#ifndef GRAPH_NO_SFML
 template<class NodeType, class ArcType>
 void Graph<NodeType, ArcType>::checkMousePos(sf::RenderWindow &window) {
 	sf::Vector2i mousePos = sf::Mouse::getPosition(window);
-	for (int i = 0; i < m_count; i++) {		
-		int tempColor = m_pNodes[i]->getColor();
-		sf::Vector2f nodePos = sf::Vector2f(m_pNodes[i]->getX() + 12.5f, m_pNodes[i]->getY() + 12.5f);
-		int distance = (int)(sqrt((pow(mousePos.x - nodePos.x, 2)) + (pow(mousePos.y - nodePos.y, 2))));
-		if (distance < 25) {
-			if (m_pNodes[i]->getColor() == 0)
-				m_pNodes[i]->setColor(3);			
-
-			nodeInfo.setPosition(mousePos.x, mousePos.y);
-
-			if (m_pNodes[i]->data().second < 1000000)
-				gn = sf::Text(to_string(m_pNodes[i]->data().second), font, 16);
-			else
-				gn = sf::Text("NA", font, 16);
-			gn.setPosition(mousePos.x + 50, mousePos.y + 12);
-
-			hn = sf::Text(to_string(m_pNodes[i]->getHeuristic()), font, 16);
-			hn.setPosition(mousePos.x + 50, mousePos.y + 38);
-
-			hn.setStyle(sf::Text::Bold);
-			gn.setStyle(sf::Text::Bold);
-
-			hn.setColor(sf::Color(0,0,0));
-			gn.setColor(sf::Color(0,0,0));
-			break;
-		}
-		else {
-			if (tempColor == 0 || tempColor == 3)
-				m_pNodes[i]->setColor(0);
+	//nodes are drawn 12.5 pixels right and down of their position
+	int i = spatialIndex().nearest(mousePos.x - 12.5f, mousePos.y - 12.5f, 25);
 
-			nodeInfo.setPosition(-1000, -1000);
-			gn.setPosition(-1000, -1000);
-			hn.setPosition(-1000, -1000);
-		}
+	//take the highlight off the node the mouse has left
+	if (m_hovered != -1 && m_hovered != i && m_pNodes[m_hovered]->getColor() == 3)
+		m_pNodes[m_hovered]->setColor(0);
+	m_hovered = i;
+
+	if (i != -1) {
+		if (m_pNodes[i]->getColor() == 0)
+			m_pNodes[i]->setColor(3);			
+
+		nodeInfo.setPosition(mousePos.x, mousePos.y);
+
+		if (m_pNodes[i]->data().second < 1000000)
+			gn = sf::Text(to_string(m_pNodes[i]->data().second), font, 16);
+		else
+			gn = sf::Text("NA", font, 16);
+		gn.setPosition(mousePos.x + 50, mousePos.y + 12);
 
+		hn = sf::Text(to_string(m_pNodes[i]->getHeuristic()), font, 16);
+		hn.setPosition(mousePos.x + 50, mousePos.y + 38);
 
+		hn.setStyle(sf::Text::Bold);
+		gn.setStyle(sf::Text::Bold);
+
+		hn.setColor(sf::Color(0,0,0));
+		gn.setColor(sf::Color(0,0,0));
+	}
+	else {
+		nodeInfo.setPosition(-1000, -1000);
+		gn.setPosition(-1000, -1000);
+		hn.setPosition(-1000, -1000);
 	}
 }
 
@@ -618,22 +2162,18 @@ void Graph<NodeType, ArcType>::selectNodes(sf::RenderWindow &window) {
 	sf::Event event;
 	while (window.pollEvent(event)) {
 		if (event.type == sf::Event::MouseButtonReleased && event.mouseButton.button == sf::Mouse::Left) {
-			for (int i = 0; i < m_count; i++) {
-				sf::Vector2f nodePos = sf::Vector2f(m_pNodes[i]->getX() + 12.5f, m_pNodes[i]->getY() + 12.5f);
-				int distance = (int)(sqrt((pow(mousePos.x - nodePos.x, 2)) + (pow(mousePos.y - nodePos.y, 2))));
-				if (distance < 25) {
-					if (!start) {
-						m_pNodes[i]->setColor(4);
-						start = true; 
-						startNode = m_pNodes[i]->data().first;
-					}
-					else {
-						m_pNodes[i]->setColor(5);
-						end = true;
-						goalNode  = m_pNodes[i]->data().first;
-						search = true;
-					}
-					break;
+			int i = spatialIndex().nearest(mousePos.x - 12.5f, mousePos.y - 12.5f, 25);
+			if (i != -1) {
+				if (!start) {
+					m_pNodes[i]->setColor(4);
+					start = true; 
+					startNode = m_pNodes[i]->data().first;
+				}
+				else {
+					m_pNodes[i]->setColor(5);
+					end = true;
+					goalNode  = m_pNodes[i]->data().first;
+					search = true;
 				}
 			}
 			if (mousePos.x > 1020 && mousePos.x < 1120 && mousePos.y > 200 && mousePos.y < 270) {
@@ -653,9 +2193,11 @@ void Graph<NodeType, ArcType>::drawNodeInfo(sf::RenderWindow &window) {
 	window.draw(gn);
 	window.draw(hn);
 }
+#endif
 
 #include "GraphNode.h"
 #include "GraphArc.h"
+#include "GraphVisitor.h"
 
 
 #endif
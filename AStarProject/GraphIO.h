@@ -0,0 +1,201 @@
+#ifndef GRAPHIO_H
+#define GRAPHIO_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <utility>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+#include "Graph.h"
+
+// ----------------------------------------------------------------
+//  Description:    Loading and saving graphs whose nodes hold a name
+//                  and a cost, like the viewer's. The text format is
+//                  the viewer's Nodes.txt ("name x y" per line) and
+//                  Arcs.txt ("from to weight" per line). The binary
+//                  format holds the same graph for fast loading:
+//
+//                  "AGRF", format version, sizeof(ArcType),
+//                  node count, arc count (all 4-byte integers), then
+//                  x, y, name length and name for every node, then
+//                  from, to and weight for every arc.
+// ----------------------------------------------------------------
+const unsigned int GRAPH_FILE_VERSION = 1;
+
+// ----------------------------------------------------------------
+//  Name:           loadTextGraph
+//  Description:    Loads a graph from a node file and an arc file.
+//                  By default it matches the viewer: positions are
+//                  scaled up the same way and every arc weighs its
+//                  length, ignoring the file's weight. With
+//                  fileWeights, positions and weights are used as
+//                  written; the weights should then be no shorter
+//                  than the distances or A* may miss the best path.
+//  Arguments:      The first parameter is the node file.
+//                  The second parameter is the arc file.
+//                  The third parameter picks the weights, as above.
+//  Return Value:   The new graph, or 0 if a file can't be read.
+// ----------------------------------------------------------------
+template<class ArcType>
+Graph<pair<string, int>, ArcType>* loadTextGraph( const string& nodesFile, const string& arcsFile, bool fileWeights = false ) {
+	ifstream nodes( nodesFile.c_str() );
+	ifstream arcs( arcsFile.c_str() );
+	if( !nodes || !arcs ) {
+		return 0;
+	}
+
+	vector<string> names;
+	vector< pair<int, int> > positions;
+	string name;
+	int x, y;
+	while( nodes >> name >> x >> y ) {
+		names.push_back( name );
+		if( fileWeights == true ) {
+			positions.push_back( make_pair( x, y ) );
+		}
+		else {
+			positions.push_back( make_pair( (int)(x * 2 / 1.1), (int)(y * 2 / 1.1) ) );
+		}
+	}
+
+	Graph<pair<string, int>, ArcType>* pGraph = new Graph<pair<string, int>, ArcType>( (int)names.size() );
+	pair<string, int> data;
+	data.second = INT_MAX;
+	for( size_t i = 0; i < names.size(); i++ ) {
+		data.first = names[i];
+		pGraph->addNode( data, (int)i, positions[i] );
+	}
+
+	int from, to;
+	ArcType weight;
+	while( arcs >> from >> to >> weight ) {
+		if( from < 0 || to < 0 || from >= (int)names.size() || to >= (int)names.size() ) {
+			continue;
+		}
+		if( fileWeights == false ) {
+			double dx = positions[to].first - positions[from].first;
+			double dy = positions[to].second - positions[from].second;
+			weight = (ArcType)(int)sqrt( dx * dx + dy * dy );
+		}
+		pGraph->addArc( from, to, weight );
+	}
+	return pGraph;
+}
+
+// ----------------------------------------------------------------
+//  Name:           saveBinaryGraph
+//  Description:    Writes a graph in the binary format. Nodes are
+//                  saved under their current indices.
+//  Arguments:      The first parameter is the graph.
+//                  The second parameter is the file to write.
+//  Return Value:   true if the file was written.
+// ----------------------------------------------------------------
+template<class ArcType>
+bool saveBinaryGraph( Graph<pair<string, int>, ArcType>& graph, const string& file ) {
+	typedef GraphArc<pair<string, int>, ArcType> Arc;
+	ofstream out( file.c_str(), ios::binary );
+	if( !out ) {
+		return false;
+	}
+
+	int nodeCount = graph.maxSize();
+	int arcCount = 0;
+	for( int i = 0; i < nodeCount; i++ ) {
+		if( graph.nodeArray()[i] != 0 ) {
+			arcCount += (int)graph.nodeArray()[i]->arcList().size();
+		}
+	}
+	unsigned int header[5] = { 0, GRAPH_FILE_VERSION, sizeof( ArcType ), (unsigned int)nodeCount, (unsigned int)arcCount };
+	memcpy( &header[0], "AGRF", 4 );
+	out.write( (const char*)header, sizeof( header ) );
+
+	// a missing node is written with a name length of -1.
+	for( int i = 0; i < nodeCount; i++ ) {
+		GraphNode<pair<string, int>, ArcType>* pNode = graph.nodeArray()[i];
+		int fields[3] = { 0, 0, -1 };
+		if( pNode != 0 ) {
+			fields[0] = pNode->getX();
+			fields[1] = pNode->getY();
+			fields[2] = (int)pNode->data().first.size();
+		}
+		out.write( (const char*)fields, sizeof( fields ) );
+		if( pNode != 0 ) {
+			out.write( pNode->data().first.data(), fields[2] );
+		}
+	}
+
+	for( int i = 0; i < nodeCount; i++ ) {
+		if( graph.nodeArray()[i] == 0 ) {
+			continue;
+		}
+		typename list<Arc>::const_iterator iter = graph.nodeArray()[i]->arcList().begin();
+		typename list<Arc>::const_iterator endIter = graph.nodeArray()[i]->arcList().end();
+		for( ; iter != endIter; ++iter ) {
+			int ends[2] = { i, (*iter).node()->getIndex() };
+			ArcType weight = (*iter).weight();
+			out.write( (const char*)ends, sizeof( ends ) );
+			out.write( (const char*)&weight, sizeof( ArcType ) );
+		}
+	}
+	return out.good();
+}
+
+// ----------------------------------------------------------------
+//  Name:           loadBinaryGraph
+//  Description:    Reads a graph written by saveBinaryGraph.
+//  Arguments:      The file to read.
+//  Return Value:   The new graph, or 0 if the file can't be read,
+//                  isn't a graph of this arc type or is damaged.
+// ----------------------------------------------------------------
+template<class ArcType>
+Graph<pair<string, int>, ArcType>* loadBinaryGraph( const string& file ) {
+	ifstream in( file.c_str(), ios::binary );
+	unsigned int header[5];
+	if( !in.read( (char*)header, sizeof( header ) ) ||
+		memcmp( &header[0], "AGRF", 4 ) != 0 || header[1] != GRAPH_FILE_VERSION || header[2] != sizeof( ArcType ) ) {
+		return 0;
+	}
+	int nodeCount = (int)header[3];
+	int arcCount = (int)header[4];
+	if( nodeCount < 0 || arcCount < 0 ) {
+		return 0;
+	}
+
+	Graph<pair<string, int>, ArcType>* pGraph = new Graph<pair<string, int>, ArcType>( nodeCount );
+	pair<string, int> data;
+	data.second = INT_MAX;
+	for( int i = 0; i < nodeCount; i++ ) {
+		int fields[3];
+		if( !in.read( (char*)fields, sizeof( fields ) ) ) {
+			delete pGraph;
+			return 0;
+		}
+		if( fields[2] >= 0 ) {
+			data.first.resize( fields[2] );
+			if( fields[2] > 0 && !in.read( &data.first[0], fields[2] ) ) {
+				delete pGraph;
+				return 0;
+			}
+			pGraph->addNode( data, i, make_pair( fields[0], fields[1] ) );
+		}
+	}
+
+	for( int i = 0; i < arcCount; i++ ) {
+		int ends[2];
+		ArcType weight;
+		if( !in.read( (char*)ends, sizeof( ends ) ) || !in.read( (char*)&weight, sizeof( ArcType ) ) ||
+			ends[0] < 0 || ends[0] >= nodeCount || ends[1] < 0 || ends[1] >= nodeCount ||
+			pGraph->nodeArray()[ends[0]] == 0 || pGraph->nodeArray()[ends[1]] == 0 ) {
+			// an arc to a slot with no node means the file is damaged.
+			delete pGraph;
+			return 0;
+		}
+		pGraph->addArc( ends[0], ends[1], weight );
+	}
+	return pGraph;
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define GRAPHNODE_H
 
 #include <list>
+#include <vector>
 
 // Forward references
 template <typename NodeType, typename ArcType> class GraphArc;
@@ -46,9 +47,28 @@ private:
 	// 0 = BLUE, 1 = YELLOW, 2 = RED, 3 = HIGHLIGHTED
 	int colour;
 
+// -------------------------------------------------------
+// Description: Where the graph collects the nodes whose colour
+//              changed (0 if it doesn't), and whether this node
+//              is in that list already.
+// -------------------------------------------------------
+	vector<int>* m_pColorChanges;
+	bool m_colorChanged;
+
 //store the previous node that accessed this node
 	GraphNode<NodeType, ArcType>* previousNode;
 
+// -------------------------------------------------------
+// Description: Index of the node in the graph's node array
+// -------------------------------------------------------
+	int m_index;
+
+// -------------------------------------------------------
+// Description: Category used by the graph's category index
+//              (-1 if the node has none)
+// -------------------------------------------------------
+	int m_category;
+
 public:
     // Accessor functions
 
@@ -57,6 +77,10 @@ public:
 		previousNode = NULL;
 		heuristicValue = 0;
 		colour = 0;
+		m_pColorChanges = 0;
+		m_colorChanged = false;
+		m_index = -1;
+		m_category = -1;
 	}
 
     list<Arc> const & arcList() const {
@@ -113,8 +137,39 @@ public:
 	}
 	
 	void setColor(int color) {
+		if( color != colour && m_pColorChanges != 0 && m_colorChanged == false ) {
+			m_colorChanged = true;
+			m_pColorChanges->push_back( m_index );
+		}
 		colour = color;
 	}
+
+	// reports colour changes to a list, or to none if 0.
+	void trackColor(vector<int>* pChanges) {
+		m_pColorChanges = pChanges;
+		m_colorChanged = false;
+	}
+
+	// lets the next colour change be reported again.
+	void clearColorChange() {
+		m_colorChanged = false;
+	}
+
+	int getIndex() const {
+		return m_index;
+	}
+
+	void setIndex(int index) {
+		m_index = index;
+	}
+
+	int getCategory() const {
+		return m_category;
+	}
+
+	void setCategory(int category) {
+		m_category = category;
+	}
     
            
     Arc* getArc( Node* pNode );    
@@ -179,15 +234,14 @@ void GraphNode<NodeType, ArcType>::addArc( Node* pNode, ArcType weight ) {
 // ----------------------------------------------------------------
 template<typename NodeType, typename ArcType>
 void GraphNode<NodeType, ArcType>::removeArc( Node* pNode ) {
-     list<Arc>::iterator iter = m_arcList.begin();
-     list<Arc>::iterator endIter = m_arcList.end();
+     typename list<Arc>::iterator iter = m_arcList.begin();
+     typename list<Arc>::iterator endIter = m_arcList.end();
 
-     int size = m_arcList.size();
      // find the arc that matches the node
-     for( ; iter != endIter && m_arcList.size() == size;  
-                                                    ++iter ) {
+     for( ; iter != endIter; ++iter ) {
           if ( (*iter).node() == pNode) {
-             m_arcList.remove( (*iter) );
+             m_arcList.erase( iter );
+             break;
           }                           
      }
 }
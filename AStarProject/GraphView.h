@@ -0,0 +1,288 @@
+#ifndef GRAPHVIEW_H
+#define GRAPHVIEW_H
+
+#include <vector>
+#include <string>
+
+#include "Graph.h"
+
+// ----------------------------------------------------------------
+//  Name:           GraphView
+//  Description:    Draws a graph in the viewer with a handful of draw
+//                  calls, however big the graph is. The arcs, their
+//                  weights, the nodes and their names are each built
+//                  once into a vertex array. The labels are quads cut
+//                  from the font's own glyph texture, and each node is
+//                  two quads of a white disc texture tinted with its
+//                  outline and fill colours. After that, a frame only
+//                  recolours the nodes the graph reports as changed,
+//                  so its cost follows what changed rather than the
+//                  size of the graph.
+//                  Include SFML before this file.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+class GraphView {
+private:
+	// node circles are this wide, drawn down and right of the node's
+	// position, with an outline of OUTLINE pixels.
+	static const int NODE_SIZE = 25;
+	static const int OUTLINE = 4;
+	static const int DISC_SIZE = 128;
+
+	static const unsigned int WEIGHT_TEXT = 20;
+	static const unsigned int NAME_TEXT = 30;
+
+	const sf::Font& m_font;
+	sf::Texture m_disc;
+
+	sf::VertexArray m_arcs;
+	sf::VertexArray m_weights;
+	sf::VertexArray m_discs;
+	sf::VertexArray m_names;
+
+	// the colour each node was last drawn with, and the nodes the
+	// graph last reported as changed.
+	vector<int> m_colors;
+	vector<int> m_changed;
+
+	void appendText( sf::VertexArray& vertices, const string& text, unsigned int size, bool bold, sf::Vector2f position, sf::Color color );
+	void appendQuad( sf::VertexArray& vertices, sf::Vector2f centre, float half, sf::Color color, float textureSize );
+	void setQuadColor( int first, sf::Color color );
+	bool recolor( int node, GraphNode<NodeType, ArcType>* pNode );
+	static void styleFor( int color, sf::Color& fill, sf::Color& outline );
+
+public:
+	GraphView( const sf::Font& font );
+
+	void build( Graph<NodeType, ArcType>& graph );
+	int update( Graph<NodeType, ArcType>& graph );
+	void draw( sf::RenderTarget& target ) const;
+};
+
+// ----------------------------------------------------------------
+//  Name:           GraphView
+//  Description:    Constructor, draws the disc texture the nodes use.
+//  Arguments:      The font for the weights and names.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+GraphView<NodeType, ArcType>::GraphView( const sf::Font& font ) :
+	m_font( font ), m_arcs( sf::Lines ), m_weights( sf::Quads ), m_discs( sf::Quads ), m_names( sf::Quads ) {
+	sf::Image disc;
+	disc.create( DISC_SIZE, DISC_SIZE, sf::Color( 255, 255, 255, 0 ) );
+	float radius = DISC_SIZE / 2.0f;
+	for( int y = 0; y < DISC_SIZE; y++ ) {
+		for( int x = 0; x < DISC_SIZE; x++ ) {
+			float dx = x + 0.5f - radius;
+			float dy = y + 0.5f - radius;
+			// fade the last pixel of the edge to smooth it.
+			float inside = radius - sqrt( dx * dx + dy * dy );
+			if( inside > 0 ) {
+				disc.setPixel( x, y, sf::Color( 255, 255, 255, inside >= 1 ? 255 : (sf::Uint8)(inside * 255) ) );
+			}
+		}
+	}
+	m_disc.loadFromImage( disc );
+	m_disc.setSmooth( true );
+}
+
+// ----------------------------------------------------------------
+//  Name:           styleFor
+//  Description:    The viewer's colours for each node state:
+//                  0 = normal, 1 = on the path, 2 = searched,
+//                  3 = highlighted, 4 = start, 5 = goal.
+//  Arguments:      The first parameter is the node's colour number.
+//                  The second and third parameters are filled with
+//                  the fill and outline colours.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void GraphView<NodeType, ArcType>::styleFor( int color, sf::Color& fill, sf::Color& outline ) {
+	switch( color ) {
+	case 0:
+		fill = sf::Color( 0, 255, 255 );
+		outline = sf::Color( 0, 102, 0 );
+		break;
+	case 2:
+		fill = sf::Color( 68, 243, 267 );
+		outline = sf::Color( 0, 102, 0 );
+		break;
+	case 4:
+		fill = sf::Color( 240, 0, 0 );
+		outline = sf::Color( 240, 230, 140 );
+		break;
+	default:
+		fill = sf::Color( 240, 230, 140 );
+		outline = sf::Color( 255, 0, 0 );
+		break;
+	}
+}
+
+template<class NodeType, class ArcType>
+void GraphView<NodeType, ArcType>::appendQuad( sf::VertexArray& vertices, sf::Vector2f centre, float half, sf::Color color, float textureSize ) {
+	vertices.append( sf::Vertex( centre + sf::Vector2f( -half, -half ), color, sf::Vector2f( 0, 0 ) ) );
+	vertices.append( sf::Vertex( centre + sf::Vector2f( half, -half ), color, sf::Vector2f( textureSize, 0 ) ) );
+	vertices.append( sf::Vertex( centre + sf::Vector2f( half, half ), color, sf::Vector2f( textureSize, textureSize ) ) );
+	vertices.append( sf::Vertex( centre + sf::Vector2f( -half, half ), color, sf::Vector2f( 0, textureSize ) ) );
+}
+
+template<class NodeType, class ArcType>
+void GraphView<NodeType, ArcType>::setQuadColor( int first, sf::Color color ) {
+	for( int i = first; i < first + 4; i++ ) {
+		m_discs[i].color = color;
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           recolor
+//  Description:    Restyles one node's quads if its colour differs
+//                  from the one it was drawn with.
+//  Arguments:      The first parameter is the node index.
+//                  The second parameter is the node.
+//  Return Value:   true if the node was restyled.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+bool GraphView<NodeType, ArcType>::recolor( int node, GraphNode<NodeType, ArcType>* pNode ) {
+	if( pNode == 0 || node >= (int)m_colors.size() || pNode->getColor() == m_colors[node] ) {
+		return false;
+	}
+	sf::Color fill;
+	sf::Color outline;
+	styleFor( pNode->getColor(), fill, outline );
+	setQuadColor( node * 8, outline );
+	setQuadColor( node * 8 + 4, fill );
+	m_colors[node] = pNode->getColor();
+	return true;
+}
+
+// ----------------------------------------------------------------
+//  Name:           appendText
+//  Description:    Adds a line of text as quads over the font's glyph
+//                  texture, laid out the same way as sf::Text.
+//  Arguments:      The first parameter is the array to add to.
+//                  The second parameter is the text.
+//                  The third and fourth parameters are the character
+//                  size and whether it is bold.
+//                  The fifth parameter is the top left of the text.
+//                  The sixth parameter is its colour.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void GraphView<NodeType, ArcType>::appendText( sf::VertexArray& vertices, const string& text, unsigned int size, bool bold, sf::Vector2f position, sf::Color color ) {
+	float x = position.x;
+	float y = position.y + size;
+	sf::Uint32 previous = 0;
+	for( size_t i = 0; i < text.size(); i++ ) {
+		sf::Uint32 letter = (unsigned char)text[i];
+		x += m_font.getKerning( previous, letter, size );
+		previous = letter;
+
+		const sf::Glyph& glyph = m_font.getGlyph( letter, size, bold );
+		float left = x + glyph.bounds.left;
+		float top = y + glyph.bounds.top;
+		float right = left + glyph.bounds.width;
+		float bottom = top + glyph.bounds.height;
+		float u1 = (float)glyph.textureRect.left;
+		float v1 = (float)glyph.textureRect.top;
+		float u2 = u1 + glyph.textureRect.width;
+		float v2 = v1 + glyph.textureRect.height;
+		vertices.append( sf::Vertex( sf::Vector2f( left, top ), color, sf::Vector2f( u1, v1 ) ) );
+		vertices.append( sf::Vertex( sf::Vector2f( right, top ), color, sf::Vector2f( u2, v1 ) ) );
+		vertices.append( sf::Vertex( sf::Vector2f( right, bottom ), color, sf::Vector2f( u2, v2 ) ) );
+		vertices.append( sf::Vertex( sf::Vector2f( left, bottom ), color, sf::Vector2f( u1, v2 ) ) );
+		x += glyph.advance;
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           build
+//  Description:    Builds the vertex arrays for a graph, with every
+//                  node in its current colour. Call it again if nodes
+//                  or arcs are added or moved, or after a reorder.
+//  Arguments:      The graph.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void GraphView<NodeType, ArcType>::build( Graph<NodeType, ArcType>& graph ) {
+	typedef GraphArc<NodeType, ArcType> Arc;
+	m_arcs.clear();
+	m_weights.clear();
+	m_discs.clear();
+	m_names.clear();
+	m_colors.assign( graph.maxSize(), -1 );
+
+	float offset = NODE_SIZE / 2;
+	for( int i = 0; i < graph.maxSize(); i++ ) {
+		GraphNode<NodeType, ArcType>* pNode = graph.nodeArray()[i];
+		if( pNode == 0 ) {
+			// keep every node's quads at 8 * its index.
+			appendQuad( m_discs, sf::Vector2f( 0, 0 ), 0, sf::Color::Transparent, 0 );
+			appendQuad( m_discs, sf::Vector2f( 0, 0 ), 0, sf::Color::Transparent, 0 );
+			continue;
+		}
+
+		sf::Vector2f start( pNode->getX() + offset, pNode->getY() + offset );
+		typename list<Arc>::const_iterator iter = pNode->arcList().begin();
+		typename list<Arc>::const_iterator endIter = pNode->arcList().end();
+		for( ; iter != endIter; ++iter ) {
+			sf::Vector2f end( (*iter).node()->getX() + offset, (*iter).node()->getY() + offset );
+			m_arcs.append( sf::Vertex( start ) );
+			m_arcs.append( sf::Vertex( end ) );
+			appendText( m_weights, to_string( (*iter).weight() ), WEIGHT_TEXT, false,
+				start + sf::Vector2f( (end - start).x / 2 - 20, (end - start).y / 2 ), sf::Color::Magenta );
+		}
+
+		// the circle's centre, as sf::CircleShape placed it with its
+		// origin at NODE_SIZE / 2.
+		sf::Vector2f centre( pNode->getX() - offset + NODE_SIZE, pNode->getY() - offset + NODE_SIZE );
+		appendQuad( m_discs, centre, NODE_SIZE + OUTLINE, sf::Color::Transparent, (float)DISC_SIZE );
+		appendQuad( m_discs, centre, NODE_SIZE, sf::Color::Transparent, (float)DISC_SIZE );
+
+		appendText( m_names, pNode->data().first, NAME_TEXT, true,
+			sf::Vector2f( pNode->getX() + 4.0f, pNode->getY() - 10.0f ), sf::Color( 0, 0, 0 ) );
+	}
+
+	// everything is drawn as it is now, so earlier changes are done.
+	graph.takeColorChanges( m_changed );
+	for( int i = 0; i < graph.maxSize(); i++ ) {
+		recolor( i, graph.nodeArray()[i] );
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           update
+//  Description:    Recolours the nodes whose colour has changed
+//                  since the last update. Only the nodes the graph
+//                  lists as changed are looked at; a node changed and
+//                  changed back is listed but left alone.
+//  Arguments:      The graph.
+//  Return Value:   The number of nodes recoloured.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+int GraphView<NodeType, ArcType>::update( Graph<NodeType, ArcType>& graph ) {
+	int changed = 0;
+	graph.takeColorChanges( m_changed );
+	for( size_t i = 0; i < m_changed.size(); i++ ) {
+		if( recolor( m_changed[i], graph.nodeArray()[m_changed[i]] ) == true ) {
+			changed++;
+		}
+	}
+	return changed;
+}
+
+// ----------------------------------------------------------------
+//  Name:           draw
+//  Description:    Draws the arcs, weights, nodes and names, in four
+//                  draw calls.
+//  Arguments:      The window or texture to draw on.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void GraphView<NodeType, ArcType>::draw( sf::RenderTarget& target ) const {
+	target.draw( m_arcs );
+	target.draw( m_weights, &m_font.getTexture( WEIGHT_TEXT ) );
+	target.draw( m_discs, &m_disc );
+	target.draw( m_names, &m_font.getTexture( NAME_TEXT ) );
+}
+
+#endif
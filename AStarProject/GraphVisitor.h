@@ -0,0 +1,88 @@
+#ifndef GRAPHVISITOR_H
+#define GRAPHVISITOR_H
+
+#include <type_traits>
+
+// Forward references
+template <typename NodeType, typename ArcType> class GraphNode;
+
+// -------------------------------------------------------
+// Name:        GraphVisitor
+// Description: Default hooks for the traversal engines
+//              depthFirstVisit and breadthFirstVisit. Derive
+//              from this and hide the hooks you need; the
+//              engine is a template over the visitor type, so
+//              the calls are resolved at compile time and can
+//              be inlined. Returning false from visit or leave
+//              stops the traversal; false from follow skips
+//              one arc.
+// -------------------------------------------------------
+template<class NodeType, class ArcType>
+class GraphVisitor {
+public:
+    typedef GraphNode<NodeType, ArcType> Node;
+
+    // called when a node is first processed (pre-order).
+    bool visit( Node* /*pNode*/ ) {
+        return true;
+    }
+
+    // called before an arc to an unvisited node is taken; false
+    // skips the arc, leaving the node for another arc to reach.
+    bool follow( Node* /*pFrom*/, Node* /*pTo*/ ) {
+        return true;
+    }
+
+    // called when an arc reaches an unvisited node.
+    void treeArc( Node* /*pFrom*/, Node* /*pTo*/ ) {
+    }
+
+    // called once every arc of a node is done (post-order).
+    bool leave( Node* /*pNode*/ ) {
+        return true;
+    }
+};
+
+// -------------------------------------------------------
+// Name:        FunctionVisitor
+// Description: Adapts any callable taking a Node* into a
+//              pre-order visitor. If the callable returns a
+//              value, false stops the traversal.
+// -------------------------------------------------------
+template<class NodeType, class ArcType, class Function>
+class FunctionVisitor : public GraphVisitor<NodeType, ArcType> {
+private:
+    typedef GraphNode<NodeType, ArcType> Node;
+
+    Function m_function;
+
+    // split on whether the callable returns anything.
+    bool call( Node* pNode, std::true_type ) {
+        m_function( pNode );
+        return true;
+    }
+
+    bool call( Node* pNode, std::false_type ) {
+        return m_function( pNode ) ? true : false;
+    }
+
+public:
+    FunctionVisitor( Function function ) : m_function( function ) {
+    }
+
+    bool visit( Node* pNode ) {
+        return call( pNode, typename std::is_void<decltype( m_function( pNode ) )>::type() );
+    }
+};
+
+// -------------------------------------------------------
+// Name:        makeVisitor
+// Description: Wraps a callable (function pointer, functor
+//              or lambda) in a FunctionVisitor.
+// -------------------------------------------------------
+template<class NodeType, class ArcType, class Function>
+FunctionVisitor<NodeType, ArcType, Function> makeVisitor( Function function ) {
+    return FunctionVisitor<NodeType, ArcType, Function>( function );
+}
+
+#endif
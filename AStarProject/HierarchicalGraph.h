@@ -0,0 +1,592 @@
+#ifndef HIERARCHICALGRAPH_H
+#define HIERARCHICALGRAPH_H
+
+#include <vector>
+#include <queue>
+#include <limits>
+#include <utility>
+#include <functional>
+
+#include "Graph.h"
+
+// ----------------------------------------------------------------
+//  Name:           HierarchicalGraph
+//  Description:    Two level abstraction of a graph for hierarchical
+//                  path-finding (HPA*). The node positions are split
+//                  into square clusters. Nodes with an arc crossing a
+//                  cluster border are entrances; they become the nodes
+//                  of an abstract Graph, linked by the crossing arcs
+//                  and by the shortest distance between every pair of
+//                  entrances inside the same cluster.
+//
+//                  findPath runs A* (a SearchEngine with no observer)
+//                  on the abstract graph and returns its waypoints.
+//                  refineSegment then expands one pair of waypoints at
+//                  a time into base nodes, so callers only pay for the
+//                  part of the path they use.
+//
+//                  Abstract slots 0 and 1 are reserved for the query
+//                  start and goal; entrances take the slots after
+//                  that and keep them even if they stop being an
+//                  entrance, so the abstract node array stays packed.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+class HierarchicalGraph {
+private:
+	typedef GraphArc<NodeType, ArcType> Arc;
+	typedef GraphNode<NodeType, ArcType> Node;
+
+	Graph<NodeType, ArcType>& m_graph;
+	Graph<NodeType, ArcType>* m_pAbstract;
+
+	int m_clusterSize;
+	int m_columns;
+	int m_minX;
+	int m_minY;
+
+	// ----------------------------------------------------------------
+	//  Description:    Cluster of every base node and the nodes in
+	//                  each cluster.
+	// ----------------------------------------------------------------
+	vector<int> m_cluster;
+	vector< vector<int> > m_members;
+
+	// ----------------------------------------------------------------
+	//  Description:    Arcs crossing a cluster border: the targets
+	//                  leaving each node and the sources entering it.
+	// ----------------------------------------------------------------
+	vector< vector<int> > m_crossingTargets;
+	vector< vector<int> > m_crossingSources;
+
+	// ----------------------------------------------------------------
+	//  Description:    Sources of the arcs into each node from inside
+	//                  its own cluster, so the goal can be searched
+	//                  backwards.
+	// ----------------------------------------------------------------
+	vector< vector<int> > m_insideSources;
+
+	// ----------------------------------------------------------------
+	//  Description:    Abstract slot of every base node (-1 if it is
+	//                  not an entrance), the slot it was last given
+	//                  (kept for reuse) and the base node of every slot.
+	// ----------------------------------------------------------------
+	vector<int> m_abstractIndex;
+	vector<int> m_slot;
+	vector<int> m_baseIndex;
+	int m_nextSlot;
+
+	// scratch space for searches restricted to one cluster, and the
+	// nodes it was set for so the next search can reset them.
+	vector<ArcType> m_distance;
+	vector<int> m_previous;
+	vector<int> m_touched;
+
+	// the abstract search, and the route it found as abstract slots.
+	SearchEngine<Graph<NodeType, ArcType>, ArcType> m_engine;
+	SearchState<ArcType> m_state;
+	vector<int> m_route;
+
+	ArcType infinity() const {
+		return numeric_limits<ArcType>::max();
+	}
+
+	int clusterOf( int node );
+	void findCrossings( int node );
+	void clearCluster( int cluster );
+	void abstractCluster( int cluster );
+	void searchCluster( int from, bool forward );
+	void linkToCluster( int slot, int node, bool outgoing );
+
+public:
+	HierarchicalGraph( Graph<NodeType, ArcType>& graph, int clusterSize );
+	~HierarchicalGraph();
+
+	Graph<NodeType, ArcType>& abstractGraph() {
+		return *m_pAbstract;
+	}
+
+	bool findPath( int start, int goal, vector<int>& waypoints, ArcType& cost );
+	bool refineSegment( const vector<int>& waypoints, int segment, vector<int>& path );
+	void nodeChanged( int node );
+	size_t bytes() const;
+};
+
+// ----------------------------------------------------------------
+//  Name:           HierarchicalGraph
+//  Description:    Constructor, splits the graph into clusters and
+//                  builds the abstract graph.
+//  Arguments:      The first parameter is the graph to abstract.
+//                  The second parameter is the cluster width and
+//                  height, in the same units as the node positions.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+HierarchicalGraph<NodeType, ArcType>::HierarchicalGraph( Graph<NodeType, ArcType>& graph, int clusterSize ) :
+	m_graph( graph ), m_clusterSize( clusterSize > 0 ? clusterSize : 1 ), m_nextSlot( 2 ) {
+	int size = m_graph.maxSize();
+	Node** pNodes = m_graph.nodeArray();
+
+	m_minX = INT_MAX;
+	m_minY = INT_MAX;
+	int maxX = INT_MIN;
+	for( int i = 0; i < size; i++ ) {
+		if( pNodes[i] != 0 ) {
+			m_minX = min( m_minX, pNodes[i]->getX() );
+			m_minY = min( m_minY, pNodes[i]->getY() );
+			maxX = max( maxX, pNodes[i]->getX() );
+		}
+	}
+	m_columns = m_minX == INT_MAX ? 1 : (maxX - m_minX) / m_clusterSize + 1;
+
+	m_cluster.assign( size, -1 );
+	for( int i = 0; i < size; i++ ) {
+		if( pNodes[i] != 0 ) {
+			m_cluster[i] = clusterOf( i );
+			if( m_cluster[i] >= (int)m_members.size() ) {
+				m_members.resize( m_cluster[i] + 1 );
+			}
+			m_members[m_cluster[i]].push_back( i );
+		}
+	}
+
+	m_crossingTargets.resize( size );
+	m_crossingSources.resize( size );
+	m_insideSources.resize( size );
+	for( int i = 0; i < size; i++ ) {
+		if( pNodes[i] != 0 ) {
+			findCrossings( i );
+		}
+	}
+
+	// the abstract graph can hold every node plus the two query slots.
+	m_pAbstract = new Graph<NodeType, ArcType>( size + 2 );
+	m_abstractIndex.assign( size, -1 );
+	m_slot.assign( size, -1 );
+	m_baseIndex.assign( size + 2, -1 );
+	m_distance.assign( size, infinity() );
+	m_previous.assign( size, -1 );
+	m_pAbstract->addNode( NodeType(), 0, make_pair( 0, 0 ) );
+	m_pAbstract->addNode( NodeType(), 1, make_pair( 0, 0 ) );
+	m_engine.openList().useStorage( m_state.open );
+
+	for( int c = 0; c < (int)m_members.size(); c++ ) {
+		abstractCluster( c );
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           ~HierarchicalGraph
+//  Description:    Destructor, deletes the abstract graph.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+HierarchicalGraph<NodeType, ArcType>::~HierarchicalGraph() {
+	delete m_pAbstract;
+}
+
+// ----------------------------------------------------------------
+//  Name:           clusterOf
+//  Description:    Works out the cluster a node's position falls in.
+//  Arguments:      The base node index.
+//  Return Value:   The cluster index.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+int HierarchicalGraph<NodeType, ArcType>::clusterOf( int node ) {
+	Node* pNode = m_graph.nodeArray()[node];
+	return ((pNode->getY() - m_minY) / m_clusterSize) * m_columns + (pNode->getX() - m_minX) / m_clusterSize;
+}
+
+// ----------------------------------------------------------------
+//  Name:           findCrossings
+//  Description:    Records the arcs of a node that leave its cluster,
+//                  replacing whatever was recorded before, and adds
+//                  the node to the sources of the arcs that stay
+//                  inside it.
+//  Arguments:      The base node index.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void HierarchicalGraph<NodeType, ArcType>::findCrossings( int node ) {
+	vector<int>& targets = m_crossingTargets[node];
+	for( size_t i = 0; i < targets.size(); i++ ) {
+		vector<int>& sources = m_crossingSources[targets[i]];
+		sources.erase( find( sources.begin(), sources.end(), node ) );
+	}
+	targets.clear();
+
+	typename list<Arc>::const_iterator iter = m_graph.nodeArray()[node]->arcList().begin();
+	typename list<Arc>::const_iterator endIter = m_graph.nodeArray()[node]->arcList().end();
+	for( ; iter != endIter; ++iter ) {
+		int to = (*iter).node()->getIndex();
+		if( m_cluster[to] != m_cluster[node] ) {
+			targets.push_back( to );
+			m_crossingSources[to].push_back( node );
+		}
+		else {
+			m_insideSources[to].push_back( node );
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           searchCluster
+//  Description:    Shortest paths from one node to the rest of its
+//                  cluster, or from the rest of the cluster to it,
+//                  never leaving the cluster. Results are left in
+//                  m_distance and m_previous; searching backwards,
+//                  m_previous holds the next node towards the root.
+//  Arguments:      The first parameter is the base node to start at.
+//                  The second parameter is false to follow the arcs
+//                  into each node instead of the arcs out of it.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void HierarchicalGraph<NodeType, ArcType>::searchCluster( int from, bool forward ) {
+	typedef pair<ArcType, int> Entry;
+	priority_queue< Entry, vector<Entry>, greater<Entry> > nodeQueue;
+	Node** pNodes = m_graph.nodeArray();
+	int cluster = m_cluster[from];
+
+	for( size_t i = 0; i < m_touched.size(); i++ ) {
+		m_distance[m_touched[i]] = infinity();
+		m_previous[m_touched[i]] = -1;
+	}
+	m_touched.clear();
+
+	m_distance[from] = 0;
+	m_touched.push_back( from );
+	nodeQueue.push( Entry( 0, from ) );
+	while( nodeQueue.size() != 0 ) {
+		Entry top = nodeQueue.top();
+		nodeQueue.pop();
+		if( top.first > m_distance[top.second] ) {
+			continue;
+		}
+		if( forward == false ) {
+			const vector<int>& sources = m_insideSources[top.second];
+			for( size_t s = 0; s < sources.size(); s++ ) {
+				int to = sources[s];
+				ArcType distance = top.first + pNodes[to]->getArc( pNodes[top.second] )->weight();
+				if( distance < m_distance[to] ) {
+					if( m_distance[to] == infinity() ) {
+						m_touched.push_back( to );
+					}
+					m_distance[to] = distance;
+					m_previous[to] = top.second;
+					nodeQueue.push( Entry( distance, to ) );
+				}
+			}
+			continue;
+		}
+		typename list<Arc>::const_iterator iter = pNodes[top.second]->arcList().begin();
+		typename list<Arc>::const_iterator endIter = pNodes[top.second]->arcList().end();
+		for( ; iter != endIter; ++iter ) {
+			int to = (*iter).node()->getIndex();
+			ArcType distance = top.first + (*iter).weight();
+			if( m_cluster[to] == cluster && distance < m_distance[to] ) {
+				if( m_distance[to] == infinity() ) {
+					m_touched.push_back( to );
+				}
+				m_distance[to] = distance;
+				m_previous[to] = top.second;
+				nodeQueue.push( Entry( distance, to ) );
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           clearCluster
+//  Description:    Removes every abstract arc into or out of the
+//                  entrances of a cluster and frees their slots.
+//  Arguments:      The cluster index.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void HierarchicalGraph<NodeType, ArcType>::clearCluster( int cluster ) {
+	Node** pAbstract = m_pAbstract->nodeArray();
+	vector<int> targets;
+	for( size_t m = 0; m < m_members[cluster].size(); m++ ) {
+		int node = m_members[cluster][m];
+		int slot = m_abstractIndex[node];
+		if( slot == -1 ) {
+			continue;
+		}
+		// outgoing arcs.
+		targets.clear();
+		typename list<Arc>::const_iterator iter = pAbstract[slot]->arcList().begin();
+		typename list<Arc>::const_iterator endIter = pAbstract[slot]->arcList().end();
+		for( ; iter != endIter; ++iter ) {
+			targets.push_back( (*iter).node()->getIndex() );
+		}
+		for( size_t t = 0; t < targets.size(); t++ ) {
+			m_pAbstract->removeArc( slot, targets[t] );
+		}
+		// incoming arcs come from entrances in this cluster, which
+		// are cleared here too, or along crossing arcs.
+		for( size_t s = 0; s < m_crossingSources[node].size(); s++ ) {
+			int from = m_abstractIndex[m_crossingSources[node][s]];
+			if( from != -1 ) {
+				m_pAbstract->removeArc( from, slot );
+			}
+		}
+		m_abstractIndex[node] = -1;
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           abstractCluster
+//  Description:    Finds the entrances of a cluster, gives them
+//                  abstract slots and links them to each other and
+//                  to the entrances of the neighbouring clusters.
+//  Arguments:      The cluster index.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void HierarchicalGraph<NodeType, ArcType>::abstractCluster( int cluster ) {
+	Node** pNodes = m_graph.nodeArray();
+	vector<int> entrances;
+	for( size_t m = 0; m < m_members[cluster].size(); m++ ) {
+		int node = m_members[cluster][m];
+		if( m_crossingTargets[node].size() != 0 || m_crossingSources[node].size() != 0 ) {
+			entrances.push_back( node );
+		}
+	}
+
+	// reuse the slot a node had before, so slots never go stale.
+	for( size_t e = 0; e < entrances.size(); e++ ) {
+		int node = entrances[e];
+		if( m_slot[node] == -1 ) {
+			m_slot[node] = m_nextSlot++;
+			m_pAbstract->addNode( pNodes[node]->data(), m_slot[node], make_pair( pNodes[node]->getX(), pNodes[node]->getY() ) );
+			m_baseIndex[m_slot[node]] = node;
+		}
+		m_abstractIndex[node] = m_slot[node];
+	}
+
+	// inside the cluster, entrances are linked by their shortest distance.
+	for( size_t e = 0; e < entrances.size(); e++ ) {
+		searchCluster( entrances[e], true );
+		for( size_t other = 0; other < entrances.size(); other++ ) {
+			if( other != e && m_distance[entrances[other]] != infinity() ) {
+				m_pAbstract->addArc( m_abstractIndex[entrances[e]], m_abstractIndex[entrances[other]], m_distance[entrances[other]] );
+			}
+		}
+	}
+
+	// across the border, entrances are linked by the base arcs.
+	for( size_t e = 0; e < entrances.size(); e++ ) {
+		int node = entrances[e];
+		for( size_t t = 0; t < m_crossingTargets[node].size(); t++ ) {
+			int to = m_crossingTargets[node][t];
+			if( m_abstractIndex[to] != -1 ) {
+				m_pAbstract->addArc( m_abstractIndex[node], m_abstractIndex[to], pNodes[node]->getArc( pNodes[to] )->weight() );
+			}
+		}
+		for( size_t s = 0; s < m_crossingSources[node].size(); s++ ) {
+			int from = m_crossingSources[node][s];
+			if( m_abstractIndex[from] != -1 ) {
+				m_pAbstract->addArc( m_abstractIndex[from], m_abstractIndex[node], pNodes[from]->getArc( pNodes[node] )->weight() );
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           linkToCluster
+//  Description:    Links a query slot to the entrances of the
+//                  cluster a base node is in. One search from the
+//                  node covers every entrance, run backwards when
+//                  the links lead into the slot.
+//  Arguments:      The first parameter is the query slot (0 or 1).
+//                  The second parameter is the base node.
+//                  The third parameter is true to link from the slot
+//                  to the entrances, false for the other way.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void HierarchicalGraph<NodeType, ArcType>::linkToCluster( int slot, int node, bool outgoing ) {
+	int cluster = m_cluster[node];
+	searchCluster( node, outgoing );
+	for( size_t m = 0; m < m_members[cluster].size(); m++ ) {
+		int entrance = m_members[cluster][m];
+		if( m_abstractIndex[entrance] == -1 || m_distance[entrance] == infinity() ) {
+			continue;
+		}
+		if( outgoing == true ) {
+			m_pAbstract->addArc( slot, m_abstractIndex[entrance], m_distance[entrance] );
+		}
+		else {
+			m_pAbstract->addArc( m_abstractIndex[entrance], slot, m_distance[entrance] );
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           findPath
+//  Description:    Plans a path through the abstract graph. The
+//                  start and goal are linked into the query slots,
+//                  A* runs over the entrances, and the links are
+//                  removed again afterwards. The search only reads
+//                  the abstract graph, so the viewer's colours and
+//                  costs are left alone, and it skips the
+//                  connectivity index, which the query links would
+//                  invalidate on every call.
+//  Arguments:      The first parameter is the start base node.
+//                  The second parameter is the goal base node.
+//                  The third parameter is filled with the base nodes
+//                  the path passes through, from start to goal.
+//                  The fourth parameter is set to the path cost.
+//  Return Value:   true if a path was found.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+bool HierarchicalGraph<NodeType, ArcType>::findPath( int start, int goal, vector<int>& waypoints, ArcType& cost ) {
+	Node** pNodes = m_graph.nodeArray();
+	Node** pAbstract = m_pAbstract->nodeArray();
+	waypoints.clear();
+
+	pAbstract[0]->setData( pNodes[start]->data() );
+	pAbstract[0]->setPosition( make_pair( pNodes[start]->getX(), pNodes[start]->getY() ) );
+	pAbstract[1]->setData( pNodes[goal]->data() );
+	pAbstract[1]->setPosition( make_pair( pNodes[goal]->getX(), pNodes[goal]->getY() ) );
+	m_baseIndex[0] = start;
+	m_baseIndex[1] = goal;
+
+	linkToCluster( 0, start, true );
+	linkToCluster( 1, goal, false );
+	if( m_cluster[start] == m_cluster[goal] ) {
+		// a path inside the cluster may beat leaving it.
+		searchCluster( start, true );
+		if( m_distance[goal] != infinity() ) {
+			m_pAbstract->addArc( 0, 1, m_distance[goal] );
+		}
+	}
+
+	QuerySummary<ArcType> result = m_engine.run( *m_pAbstract, 0, 1, m_state );
+	cost = infinity();
+	if( result.status == QUERY_FOUND ) {
+		m_state.writePath( result.end, m_route );
+		for( size_t i = 0; i < m_route.size(); i++ ) {
+			waypoints.push_back( m_baseIndex[m_route[i]] );
+		}
+		cost = result.cost;
+	}
+
+	// unlink the query slots.
+	while( pAbstract[0]->arcList().size() != 0 ) {
+		m_pAbstract->removeArc( 0, pAbstract[0]->arcList().front().node()->getIndex() );
+	}
+	int goalCluster = m_cluster[goal];
+	for( size_t m = 0; m < m_members[goalCluster].size(); m++ ) {
+		if( m_abstractIndex[m_members[goalCluster][m]] != -1 ) {
+			m_pAbstract->removeArc( m_abstractIndex[m_members[goalCluster][m]], 1 );
+		}
+	}
+
+	return waypoints.size() != 0;
+}
+
+// ----------------------------------------------------------------
+//  Name:           refineSegment
+//  Description:    Expands one step of an abstract path into the
+//                  base nodes it stands for.
+//  Arguments:      The first parameter is the path from findPath.
+//                  The second parameter is the segment to expand,
+//                  from waypoint segment to waypoint segment + 1.
+//                  The third parameter is filled with the base nodes,
+//                  including both ends.
+//  Return Value:   true if the segment could be expanded.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+bool HierarchicalGraph<NodeType, ArcType>::refineSegment( const vector<int>& waypoints, int segment, vector<int>& path ) {
+	int from = waypoints[segment];
+	int to = waypoints[segment + 1];
+	path.clear();
+
+	if( m_cluster[from] != m_cluster[to] ) {
+		// a crossing arc is a segment of its own.
+		path.push_back( from );
+		path.push_back( to );
+		return m_graph.getArc( from, to ) != 0;
+	}
+
+	searchCluster( from, true );
+	if( m_distance[to] == infinity() ) {
+		return false;
+	}
+	for( int node = to; node != -1; node = m_previous[node] ) {
+		path.push_back( node );
+	}
+	reverse( path.begin(), path.end() );
+	return true;
+}
+
+// ----------------------------------------------------------------
+//  Name:           nodeChanged
+//  Description:    Updates the abstraction after the arcs out of a
+//                  node were added, removed or reweighted. Only the
+//                  clusters the node's crossing arcs touch, before
+//                  and after the change, are rebuilt.
+//  Arguments:      The base node index.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void HierarchicalGraph<NodeType, ArcType>::nodeChanged( int node ) {
+	vector<int> clusters( 1, m_cluster[node] );
+	for( size_t t = 0; t < m_crossingTargets[node].size(); t++ ) {
+		clusters.push_back( m_cluster[m_crossingTargets[node][t]] );
+	}
+	// the old arcs inside the cluster are gone, so look for the node
+	// among the sources of every member.
+	const vector<int>& members = m_members[m_cluster[node]];
+	for( size_t m = 0; m < members.size(); m++ ) {
+		vector<int>& sources = m_insideSources[members[m]];
+		sources.erase( remove( sources.begin(), sources.end(), node ), sources.end() );
+	}
+	findCrossings( node );
+	for( size_t t = 0; t < m_crossingTargets[node].size(); t++ ) {
+		clusters.push_back( m_cluster[m_crossingTargets[node][t]] );
+	}
+	sort( clusters.begin(), clusters.end() );
+	clusters.erase( unique( clusters.begin(), clusters.end() ), clusters.end() );
+
+	for( size_t c = 0; c < clusters.size(); c++ ) {
+		clearCluster( clusters[c] );
+	}
+	for( size_t c = 0; c < clusters.size(); c++ ) {
+		abstractCluster( clusters[c] );
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           bytes
+//  Description:    Roughly how much memory the abstraction takes on
+//                  top of the graph: the abstract graph's nodes and
+//                  arcs, the tables kept per base node and the search
+//                  scratch space.
+//  Arguments:      None.
+//  Return Value:   The size in bytes.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+size_t HierarchicalGraph<NodeType, ArcType>::bytes() const {
+	// a list element holds the arc and two links.
+	const size_t arcBytes = sizeof( Arc ) + 2 * sizeof( void* );
+	size_t total = m_pAbstract->maxSize() * sizeof( Node* ) + m_nextSlot * sizeof( Node );
+	for( int i = 0; i < m_nextSlot; i++ ) {
+		total += m_pAbstract->nodeArray()[i]->arcList().size() * arcBytes;
+	}
+	total += (m_cluster.capacity() + m_abstractIndex.capacity() + m_slot.capacity() + m_baseIndex.capacity() +
+		m_previous.capacity() + m_touched.capacity() + m_route.capacity()) * sizeof( int );
+	total += m_distance.capacity() * sizeof( ArcType ) + m_state.bytes();
+	for( size_t i = 0; i < m_members.size(); i++ ) {
+		total += sizeof( vector<int> ) + m_members[i].capacity() * sizeof( int );
+	}
+	for( size_t i = 0; i < m_crossingTargets.size(); i++ ) {
+		total += 3 * sizeof( vector<int> ) + (m_crossingTargets[i].capacity() + m_crossingSources[i].capacity() +
+			m_insideSources[i].capacity()) * sizeof( int );
+	}
+	return total;
+}
+
+#endif
@@ -0,0 +1,446 @@
+#ifndef KSHORTESTPATHS_H
+#define KSHORTESTPATHS_H
+
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <functional>
+
+#include "Graph.h"
+#include "FlowField.h"
+#include "SearchQuery.h"
+
+// ----------------------------------------------------------------
+//  Name:           Route
+//  Description:    One of the routes found by KShortestPaths.
+// ----------------------------------------------------------------
+template<class ArcType>
+struct Route {
+	ArcType cost;
+	vector<int> path;
+};
+
+// ----------------------------------------------------------------
+//  Name:           KShortestPaths
+//  Description:    The k cheapest loopless routes between two nodes,
+//                  by Yen's algorithm, without touching the graph.
+//                  Each candidate route leaves an accepted one at a
+//                  spur node and is found by a search that treats the
+//                  nodes before the spur as closed and skips the arcs
+//                  out of the spur already taken by accepted routes
+//                  with the same start.
+//
+//                  A search backwards from the goal gives the exact
+//                  cost to the goal, with nothing banned, of every
+//                  node it settles, which is the A* estimate for every
+//                  spur search. Where that search's own route from the
+//                  spur avoids everything banned it is already the
+//                  best, so no search is needed at all; otherwise the
+//                  search follows the estimate almost straight to the
+//                  goal. Given a FlowField, every node is settled.
+//                  Otherwise the backward search stops once the start
+//                  is settled, and the nodes it didn't reach get the
+//                  larger of the cost it got to and Graph::estimate,
+//                  which like the A* estimate relies on no arc being
+//                  much shorter than the straight line.
+//
+//                  As in Lawler's refinement, a route is only spurred
+//                  from the node where it left its parent onwards,
+//                  since the earlier spurs were tried for the parent.
+//                  The search state is kept between searches and
+//                  between calls.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+class KShortestPaths {
+private:
+	typedef GraphArc<NodeType, ArcType> Arc;
+	typedef GraphNode<NodeType, ArcType> Node;
+
+	// ----------------------------------------------------------------
+	//  Description:    The backward search of find( start, goal, k ),
+	//                  read like a FlowField. A node's next step is its
+	//                  previous node in the search.
+	// ----------------------------------------------------------------
+	class PartialField {
+	private:
+		const Graph<NodeType, ArcType>& m_graph;
+		const SearchState<ArcType>& m_state;
+		int m_goal;
+		ArcType m_radius;
+
+	public:
+		PartialField( const Graph<NodeType, ArcType>& graph, const SearchState<ArcType>& state, int goal, ArcType radius ) :
+			m_graph( graph ), m_state( state ), m_goal( goal ), m_radius( radius ) {
+		}
+
+		int goal() const {
+			return m_goal;
+		}
+
+		// the exact cost to the goal, numeric max if not settled.
+		ArcType distance( int node ) const {
+			return m_state.closed( node ) == true ? m_state.cost( node ) : numeric_limits<ArcType>::max();
+		}
+
+		int next( int node ) const {
+			return m_state.closed( node ) == true ? m_state.previous( node ) : -1;
+		}
+
+		bool path( int start, vector<int>& path ) const {
+			path.clear();
+			if( m_state.closed( start ) == false ) {
+				return false;
+			}
+			for( int node = start; node != -1; node = next( node ) ) {
+				path.push_back( node );
+			}
+			return true;
+		}
+
+		// every unsettled node is at least as far as the last settled.
+		ArcType estimate( int node ) const {
+			if( m_state.closed( node ) == true ) {
+				return m_state.cost( node );
+			}
+			ArcType straight = m_graph.estimate( m_graph.nodeArray()[node], m_graph.nodeArray()[m_goal] );
+			return straight > m_radius ? straight : m_radius;
+		}
+	};
+
+	// ----------------------------------------------------------------
+	//  Description:    An accepted or candidate route, with the cost
+	//                  of reaching each node on it and the index of the
+	//                  spur node it left its parent at.
+	// ----------------------------------------------------------------
+	struct Candidate {
+		vector<int> path;
+		vector<ArcType> costs;
+		int deviation;
+	};
+
+	Graph<NodeType, ArcType>& m_graph;
+	SearchState<ArcType> m_state;
+
+	// the graph's incoming arcs, kept until the graph changes, and the
+	// backward search from the goal.
+	vector<int> m_offsets;
+	vector<int> m_sources;
+	vector<ArcType> m_weights;
+	unsigned int m_reverseVersion;
+	bool m_haveReverse;
+	SearchState<ArcType> m_backward;
+
+	// targets of the arcs out of the current spur node that are banned.
+	vector<int> m_bannedTargets;
+
+	// the last spur search's route from the spur node to the goal.
+	vector<int> m_tail;
+
+	int m_searches;
+	int m_shortcuts;
+	int m_expansions;
+
+	bool banned( int target ) const {
+		return std::find( m_bannedTargets.begin(), m_bannedTargets.end(), target ) != m_bannedTargets.end();
+	}
+
+	// the spur search's estimate from each kind of field.
+	static ArcType estimate( const FlowField<NodeType, ArcType>& field, int node ) {
+		return field.distance( node );
+	}
+
+	static ArcType estimate( const PartialField& field, int node ) {
+		return field.estimate( node );
+	}
+
+	template<class Field>
+	int search( const Field& field, int start, int k, vector< Route<ArcType> >& routes );
+	template<class Field>
+	bool spur( const Field& field, const Candidate& route, int index );
+
+public:
+	KShortestPaths( Graph<NodeType, ArcType>& graph ) : m_graph( graph ), m_reverseVersion( 0 ), m_haveReverse( false ),
+		m_searches( 0 ), m_shortcuts( 0 ), m_expansions( 0 ) {
+	}
+
+	int find( int start, int goal, int k, vector< Route<ArcType> >& routes );
+	int find( const FlowField<NodeType, ArcType>& field, int start, int k, vector< Route<ArcType> >& routes );
+
+	// spur searches run, spur searches skipped by following the field
+	// and nodes expanded, all for the last call to find.
+	int searches() const {
+		return m_searches;
+	}
+
+	int shortcuts() const {
+		return m_shortcuts;
+	}
+
+	int expansions() const {
+		return m_expansions;
+	}
+};
+
+// ----------------------------------------------------------------
+//  Name:           find
+//  Description:    Finds up to k routes from start to goal, cheapest
+//                  first. The search backwards from the goal stops at
+//                  the start, so it costs about as much as one search
+//                  for the best route. The graph's incoming arcs are
+//                  gathered on the first call and kept until the graph
+//                  changes.
+//  Arguments:      The first parameter is the start node index.
+//                  The second parameter is the goal node index.
+//                  The third parameter is the most routes wanted.
+//                  The fourth parameter is filled with the routes.
+//  Return Value:   The number of routes found, fewer than k if there
+//                  are no more loopless routes.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+int KShortestPaths<NodeType, ArcType>::find( int start, int goal, int k, vector< Route<ArcType> >& routes ) {
+	typedef pair<ArcType, int> Entry;
+	greater<Entry> compare;
+
+	if( m_haveReverse == false || m_reverseVersion != m_graph.version() ) {
+		m_graph.reverseArcs( m_offsets, m_sources, m_weights );
+		m_reverseVersion = m_graph.version();
+		m_haveReverse = true;
+	}
+
+	// uniform cost search from the goal over the reversed arcs, until
+	// the start is settled.
+	ArcType radius = 0;
+	m_backward.begin( m_graph.maxSize() );
+	m_backward.reach( goal, 0, -1 );
+	m_backward.open.push_back( Entry( 0, goal ) );
+	while( m_backward.open.size() != 0 && k > 0 ) {
+		pop_heap( m_backward.open.begin(), m_backward.open.end(), compare );
+		int node = m_backward.open.back().second;
+		m_backward.open.pop_back();
+		if( m_backward.closed( node ) == true ) {
+			continue;
+		}
+		m_backward.close( node );
+		radius = m_backward.cost( node );
+		if( node == start ) {
+			break;
+		}
+		for( int slot = m_offsets[node]; slot < m_offsets[node + 1]; slot++ ) {
+			int from = m_sources[slot];
+			ArcType distance = radius + m_weights[slot];
+			if( distance < m_backward.cost( from ) ) {
+				m_backward.reach( from, distance, node );
+				m_backward.open.push_back( Entry( distance, from ) );
+				push_heap( m_backward.open.begin(), m_backward.open.end(), compare );
+			}
+		}
+	}
+
+	PartialField field( m_graph, m_backward, goal, radius );
+	return search( field, start, k, routes );
+}
+
+// ----------------------------------------------------------------
+//  Name:           find
+//  Description:    Finds up to k routes to a flow field's goal,
+//                  cheapest first. Fields from a FlowFieldCache can be
+//                  reused for many starts, and need no estimate.
+//  Arguments:      The first parameter is a flow field of the goal,
+//                  built from the graph as it is now.
+//                  The second parameter is the start node index.
+//                  The third parameter is the most routes wanted.
+//                  The fourth parameter is filled with the routes.
+//  Return Value:   The number of routes found, or -1 if the graph has
+//                  changed since the field was built.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+int KShortestPaths<NodeType, ArcType>::find( const FlowField<NodeType, ArcType>& field, int start, int k, vector< Route<ArcType> >& routes ) {
+	if( field.version() != m_graph.version() ) {
+		routes.clear();
+		m_searches = 0;
+		m_shortcuts = 0;
+		m_expansions = 0;
+		return -1;
+	}
+	return search( field, start, k, routes );
+}
+
+// ----------------------------------------------------------------
+//  Name:           search
+//  Description:    Yen's algorithm, as described above.
+//  Arguments:      The first parameter is the goal's field, a
+//                  FlowField or PartialField.
+//                  The other parameters are as for find.
+//  Return Value:   The number of routes found.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+template<class Field>
+int KShortestPaths<NodeType, ArcType>::search( const Field& field, int start, int k, vector< Route<ArcType> >& routes ) {
+	typedef pair<ArcType, int> Entry;
+	greater<Entry> compare;
+
+	routes.clear();
+	m_searches = 0;
+	m_shortcuts = 0;
+	m_expansions = 0;
+	if( k <= 0 || field.distance( start ) == numeric_limits<ArcType>::max() ) {
+		return 0;
+	}
+
+	// the best route is the field's own.
+	vector<Candidate> accepted( 1 );
+	field.path( start, accepted[0].path );
+	for( size_t i = 0; i < accepted[0].path.size(); i++ ) {
+		accepted[0].costs.push_back( field.distance( start ) - field.distance( accepted[0].path[i] ) );
+	}
+	accepted[0].deviation = 0;
+
+	// candidates waiting, cheapest first, and every route seen so far
+	// so none is offered twice.
+	vector<Candidate> candidates;
+	vector<Entry> waiting;
+	set< vector<int> > known;
+	known.insert( accepted[0].path );
+
+	while( (int)accepted.size() < k ) {
+		const Candidate& last = accepted.back();
+		for( int i = last.deviation; i + 1 < (int)last.path.size(); i++ ) {
+			// ban the next arc of every accepted route that starts the same way.
+			m_bannedTargets.clear();
+			for( size_t j = 0; j < accepted.size(); j++ ) {
+				const vector<int>& other = accepted[j].path;
+				if( (int)other.size() > i + 1 && equal( other.begin(), other.begin() + i + 1, last.path.begin() ) ) {
+					m_bannedTargets.push_back( other[i + 1] );
+				}
+			}
+			if( spur( field, last, i ) == false ) {
+				continue;
+			}
+
+			Candidate found;
+			found.path.assign( last.path.begin(), last.path.begin() + i );
+			found.costs.assign( last.costs.begin(), last.costs.begin() + i );
+			for( size_t j = 0; j < m_tail.size(); j++ ) {
+				found.path.push_back( m_tail[j] );
+				found.costs.push_back( last.costs[i] + m_state.cost( m_tail[j] ) );
+			}
+			found.deviation = i;
+			if( known.insert( found.path ).second == true ) {
+				waiting.push_back( Entry( found.costs.back(), (int)candidates.size() ) );
+				push_heap( waiting.begin(), waiting.end(), compare );
+				candidates.push_back( Candidate() );
+				candidates.back().path.swap( found.path );
+				candidates.back().costs.swap( found.costs );
+				candidates.back().deviation = found.deviation;
+			}
+		}
+
+		if( waiting.size() == 0 ) {
+			break;
+		}
+		pop_heap( waiting.begin(), waiting.end(), compare );
+		int next = waiting.back().second;
+		waiting.pop_back();
+		accepted.push_back( Candidate() );
+		accepted.back().path.swap( candidates[next].path );
+		accepted.back().costs.swap( candidates[next].costs );
+		accepted.back().deviation = candidates[next].deviation;
+	}
+
+	routes.resize( accepted.size() );
+	for( size_t i = 0; i < accepted.size(); i++ ) {
+		routes[i].cost = accepted[i].costs.back();
+		routes[i].path.swap( accepted[i].path );
+	}
+	return (int)routes.size();
+}
+
+// ----------------------------------------------------------------
+//  Name:           spur
+//  Description:    Finds the cheapest way from a route's spur node to
+//                  the goal that avoids the nodes before the spur and
+//                  the banned arcs out of it. The nodes before the
+//                  spur are marked closed in the search state, and the
+//                  search's costs are measured from the spur.
+//  Arguments:      The first parameter is the goal's field.
+//                  The second parameter is the route.
+//                  The third parameter is the spur node's index on it.
+//  Return Value:   true if there is a way, which is left in m_tail
+//                  from the spur node to the goal, with each node's
+//                  cost from the spur in the search state.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+template<class Field>
+bool KShortestPaths<NodeType, ArcType>::spur( const Field& field, const Candidate& route, int index ) {
+	typedef pair<ArcType, int> Entry;
+	greater<Entry> compare;
+	const ArcType infinity = numeric_limits<ArcType>::max();
+	int start = route.path[index];
+	int goal = field.goal();
+
+	m_state.begin( m_graph.maxSize() );
+	for( int i = 0; i < index; i++ ) {
+		m_state.close( route.path[i] );
+	}
+	m_tail.clear();
+
+	// the field's route is the best there is, if nothing on it is banned.
+	int next = field.next( start );
+	if( next != -1 && banned( next ) == false ) {
+		int node = next;
+		while( node != -1 && m_state.closed( node ) == false ) {
+			node = field.next( node );
+		}
+		if( node == -1 ) {
+			for( node = start; node != -1; node = field.next( node ) ) {
+				m_state.reach( node, field.distance( start ) - field.distance( node ), -1 );
+				m_tail.push_back( node );
+			}
+			m_shortcuts++;
+			return true;
+		}
+	}
+
+	// otherwise search, with the field's cost to the goal as the estimate.
+	m_searches++;
+	m_state.reach( start, 0, -1 );
+	m_state.open.push_back( Entry( estimate( field, start ), start ) );
+	while( m_state.open.size() != 0 ) {
+		pop_heap( m_state.open.begin(), m_state.open.end(), compare );
+		int node = m_state.open.back().second;
+		m_state.open.pop_back();
+		if( m_state.closed( node ) == true ) {
+			continue;
+		}
+		m_state.close( node );
+		if( node == goal ) {
+			m_state.writePath( goal, m_tail );
+			return true;
+		}
+		m_expansions++;
+
+		ArcType cost = m_state.cost( node );
+		Node* pNode = m_graph.nodeArray()[node];
+		typename list<Arc>::const_iterator iter = pNode->arcList().begin();
+		typename list<Arc>::const_iterator endIter = pNode->arcList().end();
+		for( ; iter != endIter; ++iter ) {
+			int to = (*iter).node()->getIndex();
+			ArcType remaining = estimate( field, to );
+			// nodes that can't reach the goal at all are never worth a visit.
+			if( remaining == infinity || m_state.closed( to ) == true || (node == start && banned( to ) == true) ) {
+				continue;
+			}
+			ArcType distance = cost + (*iter).weight();
+			if( distance < m_state.cost( to ) ) {
+				m_state.reach( to, distance, node );
+				m_state.open.push_back( Entry( distance + remaining, to ) );
+				push_heap( m_state.open.begin(), m_state.open.end(), compare );
+			}
+		}
+	}
+	return false;
+}
+
+#endif
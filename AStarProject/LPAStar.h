@@ -0,0 +1,259 @@
+#ifndef LPASTAR_H
+#define LPASTAR_H
+
+#include <set>
+#include <vector>
+#include <limits>
+#include <utility>
+
+#include "Graph.h"
+
+// ----------------------------------------------------------------
+//  Name:           LPAStar
+//  Description:    Incremental search between a fixed start and goal
+//                  (Lifelong Planning A*). The search state is kept
+//                  between calls, so after an arc is added, removed or
+//                  reweighted only the nodes whose cost it changes are
+//                  expanded again. The graph's own node data and marks
+//                  are never touched.
+//
+//                  Usage: change the arcs through the graph, call
+//                  arcChanged for each one, then computePath again.
+//                  Removing nodes is not supported; build a new
+//                  LPAStar instead.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+class LPAStar {
+private:
+	typedef GraphArc<NodeType, ArcType> Arc;
+	typedef GraphNode<NodeType, ArcType> Node;
+	// a path's cost, then its number of arcs, so that even a zero-weight
+	// arc makes a path dearer and no cycle can hold up its own costs.
+	typedef pair<ArcType, int> Cost;
+	typedef pair<ArcType, Cost> Key;
+
+	Graph<NodeType, ArcType>& m_graph;
+	int m_start;
+	int m_goal;
+
+	// ----------------------------------------------------------------
+	//  Description:    Cost so far (g), one-step lookahead cost (rhs)
+	//                  and queue key of every node.
+	// ----------------------------------------------------------------
+	vector<Cost> m_g;
+	vector<Cost> m_rhs;
+	vector<Key> m_key;
+	vector<bool> m_queued;
+
+	// ----------------------------------------------------------------
+	//  Description:    Incoming arcs of every node, as source indices.
+	// ----------------------------------------------------------------
+	vector< vector<int> > m_predecessors;
+
+	// ----------------------------------------------------------------
+	//  Description:    Nodes whose g and rhs disagree, ordered by key.
+	// ----------------------------------------------------------------
+	set< pair<Key, int> > m_open;
+
+	int m_expansions;
+
+	Cost infinity() const {
+		return Cost( numeric_limits<ArcType>::max(), numeric_limits<int>::max() );
+	}
+
+	// adds an arc without overflowing infinity.
+	Cost add( const Cost& cost, ArcType weight ) const {
+		return cost == infinity() ? infinity() : Cost( cost.first + weight, cost.second + 1 );
+	}
+
+	Key calculateKey( int node ) const;
+	void updateNode( int node );
+
+public:
+	LPAStar( Graph<NodeType, ArcType>& graph, int start, int goal );
+
+	bool computePath( vector<int>& path );
+	void arcChanged( int from, int to );
+
+	ArcType pathCost() const {
+		return m_g[m_goal].first;
+	}
+
+	// number of nodes expanded over the lifetime of the search.
+	int expansions() const {
+		return m_expansions;
+	}
+};
+
+// ----------------------------------------------------------------
+//  Name:           LPAStar
+//  Description:    Constructor, records the incoming arcs and seeds
+//                  the queue with the start node.
+//  Arguments:      The first parameter is the graph to search.
+//                  The second parameter is the start node index.
+//                  The third parameter is the goal node index.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+LPAStar<NodeType, ArcType>::LPAStar( Graph<NodeType, ArcType>& graph, int start, int goal ) :
+	m_graph( graph ), m_start( start ), m_goal( goal ), m_expansions( 0 ) {
+	int size = m_graph.maxSize();
+	m_g.assign( size, infinity() );
+	m_rhs.assign( size, infinity() );
+	m_key.assign( size, Key( infinity().first, infinity() ) );
+	m_queued.assign( size, false );
+
+	vector<int> offsets;
+	vector<int> sources;
+	vector<ArcType> weights;
+	m_graph.reverseArcs( offsets, sources, weights );
+	m_predecessors.resize( size );
+	for( int i = 0; i < size; i++ ) {
+		m_predecessors[i].assign( sources.begin() + offsets[i], sources.begin() + offsets[i + 1] );
+	}
+
+	m_rhs[m_start] = Cost( 0, 0 );
+	m_key[m_start] = calculateKey( m_start );
+	m_open.insert( make_pair( m_key[m_start], m_start ) );
+	m_queued[m_start] = true;
+}
+
+// ----------------------------------------------------------------
+//  Name:           calculateKey
+//  Description:    Queue key of a node: the best known cost plus the
+//                  heuristic, then the best known cost for ties.
+//  Arguments:      The node index.
+//  Return Value:   The key.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+typename LPAStar<NodeType, ArcType>::Key LPAStar<NodeType, ArcType>::calculateKey( int node ) const {
+	Cost best = m_g[node] < m_rhs[node] ? m_g[node] : m_rhs[node];
+	Node** pNodes = m_graph.nodeArray();
+	return Key( add( best, m_graph.estimate( pNodes[node], pNodes[m_goal] ) ).first, best );
+}
+
+// ----------------------------------------------------------------
+//  Name:           updateNode
+//  Description:    Recomputes the lookahead cost of a node from its
+//                  incoming arcs and queues it if it is inconsistent.
+//  Arguments:      The node index.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void LPAStar<NodeType, ArcType>::updateNode( int node ) {
+	Node** pNodes = m_graph.nodeArray();
+	if( node != m_start ) {
+		m_rhs[node] = infinity();
+		for( size_t i = 0; i < m_predecessors[node].size(); i++ ) {
+			int from = m_predecessors[node][i];
+			Cost cost = add( m_g[from], pNodes[from]->getArc( pNodes[node] )->weight() );
+			if( cost < m_rhs[node] ) {
+				m_rhs[node] = cost;
+			}
+		}
+	}
+
+	if( m_queued[node] == true ) {
+		m_open.erase( make_pair( m_key[node], node ) );
+		m_queued[node] = false;
+	}
+	if( m_g[node] != m_rhs[node] ) {
+		m_key[node] = calculateKey( node );
+		m_open.insert( make_pair( m_key[node], node ) );
+		m_queued[node] = true;
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           computePath
+//  Description:    Expands inconsistent nodes until the goal's cost
+//                  is settled, then walks the cheapest incoming arcs
+//                  back from the goal. Each step must reach a node
+//                  with a lower cost, so the walk always ends; if it
+//                  finds none, the path is reported as missing.
+//  Arguments:      Filled with the node indices from start to goal,
+//                  or left empty if there is no path.
+//  Return Value:   true if a path exists.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+bool LPAStar<NodeType, ArcType>::computePath( vector<int>& path ) {
+	Node** pNodes = m_graph.nodeArray();
+
+	while( m_open.size() != 0 && (m_open.begin()->first < calculateKey( m_goal ) || m_rhs[m_goal] != m_g[m_goal]) ) {
+		int node = m_open.begin()->second;
+		m_open.erase( m_open.begin() );
+		m_queued[node] = false;
+		m_expansions++;
+
+		if( m_g[node] > m_rhs[node] ) {
+			// the node got cheaper: settle it.
+			m_g[node] = m_rhs[node];
+		}
+		else {
+			// the node got dearer: reopen it along with its successors.
+			m_g[node] = infinity();
+			updateNode( node );
+		}
+
+		typename list<Arc>::const_iterator iter = pNodes[node]->arcList().begin();
+		typename list<Arc>::const_iterator endIter = pNodes[node]->arcList().end();
+		for( ; iter != endIter; ++iter ) {
+			updateNode( (*iter).node()->getIndex() );
+		}
+	}
+
+	path.clear();
+	if( m_g[m_goal] == infinity() ) {
+		return false;
+	}
+
+	// follow the cheapest incoming arc back to the start.
+	int node = m_goal;
+	path.push_back( node );
+	while( node != m_start ) {
+		int best = -1;
+		Cost bestCost = infinity();
+		for( size_t i = 0; i < m_predecessors[node].size(); i++ ) {
+			int from = m_predecessors[node][i];
+			Cost cost = add( m_g[from], pNodes[from]->getArc( pNodes[node] )->weight() );
+			if( cost < bestCost ) {
+				best = from;
+				bestCost = cost;
+			}
+		}
+		if( best == -1 || (m_g[best] < m_g[node]) == false ) {
+			path.clear();
+			return false;
+		}
+		node = best;
+		path.push_back( node );
+	}
+	reverse( path.begin(), path.end() );
+	return true;
+}
+
+// ----------------------------------------------------------------
+//  Name:           arcChanged
+//  Description:    Tells the search that the arc between two nodes
+//                  was added, removed or given a new weight in the
+//                  graph. The repair happens on the next computePath.
+//  Arguments:      The first parameter is the originating node index.
+//                  The second parameter is the ending node index.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+void LPAStar<NodeType, ArcType>::arcChanged( int from, int to ) {
+	vector<int>& predecessors = m_predecessors[to];
+	vector<int>::iterator iter = find( predecessors.begin(), predecessors.end(), from );
+	bool exists = m_graph.getArc( from, to ) != 0;
+
+	if( exists == true && iter == predecessors.end() ) {
+		predecessors.push_back( from );
+	}
+	else if( exists == false && iter != predecessors.end() ) {
+		predecessors.erase( iter );
+	}
+	updateNode( to );
+}
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+// ----------------------------------------------------------------
+//  Name:           LatencyHistogram
+//  Description:    Counts latencies in buckets 2% wide, so any
+//                  number of queries can be summarised in fixed
+//                  memory with percentiles accurate to about 2%.
+// ----------------------------------------------------------------
+class LatencyHistogram {
+private:
+	vector<unsigned long long> m_counts;
+	unsigned long long m_total;
+	double m_max;
+
+	static double bucketTop( int bucket ) {
+		return pow( 1.02, bucket );
+	}
+
+public:
+	LatencyHistogram() : m_counts( 1200, 0 ), m_total( 0 ), m_max( 0 ) {
+	}
+
+	void add( double micros ) {
+		int bucket = micros <= 1 ? 0 : (int)ceil( log( micros ) / log( 1.02 ) );
+		if( bucket >= (int)m_counts.size() ) {
+			bucket = (int)m_counts.size() - 1;
+		}
+		m_counts[bucket]++;
+		m_total++;
+		if( micros > m_max ) {
+			m_max = micros;
+		}
+	}
+
+	// the latency that a fraction of the queries came in under.
+	double percentile( double fraction ) const {
+		unsigned long long target = (unsigned long long)ceil( fraction * m_total );
+		unsigned long long seen = 0;
+		for( size_t i = 0; i < m_counts.size(); i++ ) {
+			seen += m_counts[i];
+			if( seen >= target && seen > 0 ) {
+				return min( bucketTop( (int)i ), m_max );
+			}
+		}
+		return m_max;
+	}
+
+	double maximum() const {
+		return m_max;
+	}
+};
+
+#endif
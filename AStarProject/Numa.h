@@ -0,0 +1,274 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <new>
+
+#if defined( _WIN32 )
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#elif defined( __linux__ )
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// ----------------------------------------------------------------
+//  Name:           Numa
+//  Description:    The little the searches need from the operating
+//                  system to run on machines with several memory
+//                  nodes (sockets): how many nodes there are, pinning
+//                  a thread to one node's processors and allocating
+//                  memory on a node, optionally in huge pages so a
+//                  big graph needs far fewer TLB entries.
+//
+//                  Windows places memory on the node asked for. Linux
+//                  places a page on the node of the thread that first
+//                  writes to it, so allocate and fill memory from a
+//                  thread bound to the node. Elsewhere the machine is
+//                  treated as a single node.
+// ----------------------------------------------------------------
+class Numa {
+public:
+	// ----------------------------------------------------------------
+	//  Name:           nodes
+	//  Description:    The numbers of the memory nodes that are online.
+	//                  They need not run from 0 without gaps: a machine
+	//                  can have node 0 and node 2 but no node 1.
+	//  Arguments:      The vector to fill with the node numbers, in
+	//                  increasing order.
+	//  Return Value:   None. There is always at least one node.
+	// ----------------------------------------------------------------
+	static void nodes( vector<int>& ids ) {
+		ids.clear();
+#if defined( _WIN32 )
+		ULONG highest = 0;
+		if( GetNumaHighestNodeNumber( &highest ) == TRUE ) {
+			for( ULONG node = 0; node <= highest; node++ ) {
+				ULONGLONG mask = 0;
+				if( GetNumaNodeProcessorMask( (UCHAR)node, &mask ) == TRUE && mask != 0 ) {
+					ids.push_back( (int)node );
+				}
+			}
+		}
+#elif defined( __linux__ )
+		// the list looks like "0,2-3".
+		ifstream file( "/sys/devices/system/node/online" );
+		string list;
+		if( getline( file, list ) ) {
+			readList( list, ids );
+		}
+#endif
+		if( ids.size() == 0 ) {
+			ids.push_back( 0 );
+		}
+	}
+
+	// ----------------------------------------------------------------
+	//  Name:           nodeCount
+	//  Description:    The number of memory nodes that are online.
+	//  Arguments:      None.
+	//  Return Value:   The number of nodes, at least 1.
+	// ----------------------------------------------------------------
+	static int nodeCount() {
+		vector<int> ids;
+		nodes( ids );
+		return (int)ids.size();
+	}
+
+	// ----------------------------------------------------------------
+	//  Name:           bindThread
+	//  Description:    Restricts the calling thread to the processors
+	//                  of one node.
+	//  Arguments:      The node.
+	//  Return Value:   true if the thread was bound.
+	// ----------------------------------------------------------------
+	static bool bindThread( int node ) {
+#if defined( _WIN32 )
+		ULONGLONG mask = 0;
+		if( GetNumaNodeProcessorMask( (UCHAR)node, &mask ) == FALSE || mask == 0 ) {
+			return false;
+		}
+		return SetThreadAffinityMask( GetCurrentThread(), (DWORD_PTR)mask ) != 0;
+#elif defined( __linux__ )
+		// the list looks like "0-3,8-11".
+		ifstream file( (nodePath( node ) + "/cpulist").c_str() );
+		string list;
+		if( !getline( file, list ) ) {
+			return false;
+		}
+		vector<int> numbers;
+		readList( list, numbers );
+		cpu_set_t cpus;
+		CPU_ZERO( &cpus );
+		bool any = false;
+		for( size_t i = 0; i < numbers.size(); i++ ) {
+			if( numbers[i] < CPU_SETSIZE ) {
+				CPU_SET( numbers[i], &cpus );
+				any = true;
+			}
+		}
+		return any == true && pthread_setaffinity_np( pthread_self(), sizeof( cpus ), &cpus ) == 0;
+#else
+		return node == 0;
+#endif
+	}
+
+	// ----------------------------------------------------------------
+	//  Name:           allocate
+	//  Description:    Allocates page-aligned memory on a node. Huge
+	//                  pages are tried first if asked for, falling back
+	//                  to normal pages when the system has none to give
+	//                  (on Windows this needs the "lock pages in memory"
+	//                  privilege; on Linux, pages set aside through
+	//                  vm.nr_hugepages, otherwise transparent huge pages
+	//                  are requested instead).
+	//  Arguments:      The first parameter is the node.
+	//                  The second parameter is the number of bytes.
+	//                  The third parameter asks for huge pages.
+	//                  The fourth parameter is set to whether huge pages
+	//                  were used.
+	//                  The fifth parameter is set to the size actually
+	//                  reserved, which must be passed to release.
+	//  Return Value:   The memory, or 0 if none could be allocated.
+	// ----------------------------------------------------------------
+	static void* allocate( int node, size_t bytes, bool hugePages, bool& gotHuge, size_t& reserved ) {
+		gotHuge = false;
+		reserved = 0;
+		if( bytes == 0 ) {
+			bytes = 1;
+		}
+#if defined( _WIN32 )
+		if( hugePages == true ) {
+			size_t large = GetLargePageMinimum();
+			if( large > 0 ) {
+				size_t size = (bytes + large - 1) / large * large;
+				void* pMemory = VirtualAllocExNuma( GetCurrentProcess(), 0, size,
+					MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE, (DWORD)node );
+				if( pMemory != 0 ) {
+					gotHuge = true;
+					reserved = size;
+					return pMemory;
+				}
+			}
+		}
+		void* pMemory = VirtualAllocExNuma( GetCurrentProcess(), 0, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, (DWORD)node );
+		if( pMemory != 0 ) {
+			reserved = bytes;
+		}
+		return pMemory;
+#elif defined( __linux__ )
+		(void)node;
+		size_t page = hugePages == true ? hugePageSize() : (size_t)sysconf( _SC_PAGESIZE );
+		size_t size = (bytes + page - 1) / page * page;
+#ifdef MAP_HUGETLB
+		if( hugePages == true ) {
+			void* pMemory = mmap( 0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+			if( pMemory != MAP_FAILED ) {
+				gotHuge = true;
+				reserved = size;
+				return pMemory;
+			}
+		}
+#endif
+		void* pMemory = mmap( 0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+		if( pMemory == MAP_FAILED ) {
+			return 0;
+		}
+#ifdef MADV_HUGEPAGE
+		if( hugePages == true ) {
+			madvise( pMemory, size, MADV_HUGEPAGE );
+		}
+#endif
+		reserved = size;
+		return pMemory;
+#else
+		(void)node;
+		(void)hugePages;
+		void* pMemory = ::operator new( bytes, nothrow );
+		if( pMemory != 0 ) {
+			reserved = bytes;
+		}
+		return pMemory;
+#endif
+	}
+
+	// ----------------------------------------------------------------
+	//  Name:           release
+	//  Description:    Frees memory from allocate.
+	//  Arguments:      The first parameter is the memory.
+	//                  The second parameter is the size allocate
+	//                  reserved.
+	//  Return Value:   None.
+	// ----------------------------------------------------------------
+	static void release( void* pMemory, size_t reserved ) {
+		if( pMemory == 0 ) {
+			return;
+		}
+#if defined( _WIN32 )
+		(void)reserved;
+		VirtualFree( pMemory, 0, MEM_RELEASE );
+#elif defined( __linux__ )
+		munmap( pMemory, reserved );
+#else
+		(void)reserved;
+		::operator delete( pMemory );
+#endif
+	}
+
+private:
+#if defined( __linux__ )
+	static string nodePath( int node ) {
+		stringstream path;
+		path << "/sys/devices/system/node/node" << node;
+		return path.str();
+	}
+
+	// reads a list of numbers and ranges like "0-3,8-11" from sysfs.
+	static void readList( const string& list, vector<int>& numbers ) {
+		stringstream ranges( list );
+		string range;
+		while( getline( ranges, range, ',' ) ) {
+			int first, last;
+			int fields = sscanf( range.c_str(), "%d-%d", &first, &last );
+			if( fields < 1 ) {
+				continue;
+			}
+			if( fields == 1 ) {
+				last = first;
+			}
+			for( int number = first; number <= last && number >= 0; number++ ) {
+				numbers.push_back( number );
+			}
+		}
+	}
+
+	// the default huge page size, from /proc/meminfo.
+	static size_t hugePageSize() {
+		ifstream file( "/proc/meminfo" );
+		string line;
+		while( getline( file, line ) ) {
+			unsigned long kilobytes = 0;
+			if( sscanf( line.c_str(), "Hugepagesize: %lu kB", &kilobytes ) == 1 && kilobytes > 0 ) {
+				return (size_t)kilobytes * 1024;
+			}
+		}
+		return 2 * 1024 * 1024;
+	}
+#endif
+};
+
+#endif
@@ -0,0 +1,154 @@
+#ifndef NUMAREPLICA_H
+#define NUMAREPLICA_H
+
+#include <vector>
+#include <thread>
+#include <new>
+
+#include "Numa.h"
+#include "CompressedGraph.h"
+
+// ----------------------------------------------------------------
+//  Name:           NumaReplicas
+//  Description:    One read-only copy of a compressed graph per memory
+//                  node, each held in memory local to its node and
+//                  optionally in huge pages. Workers bound to a node
+//                  search its copy, so no search reads memory across
+//                  the interconnect. Each copy is made by a thread
+//                  bound to its node, which places the pages there on
+//                  systems that allocate on first touch.
+// ----------------------------------------------------------------
+template<class ArcType>
+class NumaReplicas {
+private:
+	struct Replica {
+		void* pBlock;
+		size_t reserved;
+		bool hugePages;
+		int node;
+		CompressedGraph<ArcType>* pGraph;
+	};
+
+	// the copy's arrays start this far into its block, after the
+	// copy itself, on a fresh cache line.
+	static size_t header() {
+		return (sizeof( CompressedGraph<ArcType> ) + 63) / 64 * 64;
+	}
+
+	vector<Replica> m_replicas;
+
+	// not copyable.
+	NumaReplicas( const NumaReplicas& );
+	NumaReplicas& operator=( const NumaReplicas& );
+
+	void place( const CompressedGraph<ArcType>& source, int index, bool hugePages );
+
+public:
+	NumaReplicas( const CompressedGraph<ArcType>& source, bool hugePages, int nodes = 0 );
+	~NumaReplicas();
+
+	// the number of copies, one per node.
+	int count() const {
+		return (int)m_replicas.size();
+	}
+
+	// a copy, from 0 up to count() - 1.
+	const CompressedGraph<ArcType>& replica( int index ) const {
+		return *m_replicas[index].pGraph;
+	}
+
+	// the memory node a copy is on, for binding its workers.
+	int nodeId( int index ) const {
+		return m_replicas[index].node;
+	}
+
+	// whether a copy is in huge pages.
+	bool hugePages( int index ) const {
+		return m_replicas[index].hugePages;
+	}
+};
+
+// ----------------------------------------------------------------
+//  Name:           NumaReplicas
+//  Description:    Constructor, copies the graph onto each node, all
+//                  nodes at once.
+//  Arguments:      The first parameter is the graph to copy. It may be
+//                  freed once the copies are made.
+//                  The second parameter asks for huge pages.
+//                  The third parameter is the number of nodes to copy
+//                  to, or 0 for all of them. The copies go to the
+//                  online nodes with the lowest numbers.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class ArcType>
+NumaReplicas<ArcType>::NumaReplicas( const CompressedGraph<ArcType>& source, bool hugePages, int nodes ) {
+	vector<int> ids;
+	Numa::nodes( ids );
+	int available = (int)ids.size();
+	if( nodes <= 0 || nodes > available ) {
+		nodes = available;
+	}
+	Replica empty = { 0, 0, false, 0, 0 };
+	m_replicas.assign( nodes, empty );
+	for( int i = 0; i < nodes; i++ ) {
+		m_replicas[i].node = ids[i];
+	}
+
+	vector<thread> copiers;
+	for( int i = 0; i < nodes; i++ ) {
+		copiers.push_back( thread( [this, &source, i, hugePages, available]() {
+			if( available > 1 ) {
+				Numa::bindThread( m_replicas[i].node );
+			}
+			place( source, i, hugePages );
+		} ) );
+	}
+	for( size_t i = 0; i < copiers.size(); i++ ) {
+		copiers[i].join();
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           ~NumaReplicas
+//  Description:    Destructor, frees every copy.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class ArcType>
+NumaReplicas<ArcType>::~NumaReplicas() {
+	for( size_t i = 0; i < m_replicas.size(); i++ ) {
+		Replica& replica = m_replicas[i];
+		replica.pGraph->~CompressedGraph<ArcType>();
+		if( replica.reserved > 0 ) {
+			Numa::release( replica.pBlock, replica.reserved );
+		}
+		else {
+			::operator delete( replica.pBlock );
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           place
+//  Description:    Makes one node's copy: the graph object at the
+//                  start of a block on the node and its arrays after
+//                  it. If the node has no memory to give, the copy
+//                  goes on the heap instead, so searches still work.
+//  Arguments:      The first parameter is the graph to copy.
+//                  The second parameter is the copy's index.
+//                  The third parameter asks for huge pages.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class ArcType>
+void NumaReplicas<ArcType>::place( const CompressedGraph<ArcType>& source, int index, bool hugePages ) {
+	Replica& replica = m_replicas[index];
+	size_t size = header() + source.bytes();
+	replica.pBlock = Numa::allocate( replica.node, size, hugePages, replica.hugePages, replica.reserved );
+	if( replica.pBlock == 0 ) {
+		replica.pBlock = ::operator new( size );
+	}
+	unsigned char* pBlock = (unsigned char*)replica.pBlock;
+	replica.pGraph = new( pBlock ) CompressedGraph<ArcType>( source, pBlock + header() );
+}
+
+#endif
@@ -0,0 +1,321 @@
+#ifndef QUERYEXECUTOR_H
+#define QUERYEXECUTOR_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <utility>
+
+#include "SearchQuery.h"
+#include "Numa.h"
+
+// ----------------------------------------------------------------
+//  Name:           QueryExecutor
+//  Description:    Runs searches on a fixed pool of worker threads.
+//                  Submitting a query returns straight away with a
+//                  future, or calls a callback on the worker when the
+//                  query completes, so an event loop can keep going
+//                  while searches run. At most maxInFlight queries are
+//                  queued or running at once; beyond that, submit
+//                  waits for room, which stops a fast producer from
+//                  piling up unbounded work. A callback may submit
+//                  follow-up queries: those are let past the limit
+//                  rather than wait, since the worker they would wait
+//                  for is the one running the callback. A callback
+//                  must not call wait(). GraphType is anything with
+//                  a boundedSearch like Graph's that returns a
+//                  QuerySummary, such as Graph or CompressedGraph. The
+//                  graph must not change while queries are in flight.
+//                  On a machine with several memory nodes, give each
+//                  node an executor over that node's copy of the
+//                  graph (see NumaReplicas) with its workers bound to
+//                  the node.
+// ----------------------------------------------------------------
+template<class GraphType, class ArcType>
+class QueryExecutor {
+public:
+	typedef QueryResult<ArcType> Result;
+	typedef function<void ( const Result& )> Callback;
+
+private:
+	struct Job {
+		int start;
+		int goal;
+		QueryOptions options;
+		Callback callback;
+		promise<Result> done;
+	};
+
+	const GraphType& m_graph;
+	vector<thread> m_workers;
+
+	// jobs waiting for a worker, oldest first.
+	deque<Job*> m_queue;
+	mutex m_lock;
+	condition_variable m_ready;
+	condition_variable m_space;
+
+	size_t m_maxInFlight;
+	size_t m_inFlight;
+	bool m_stopping;
+
+	void work();
+	bool onWorker() const;
+	Job* makeJob( int start, int goal, const QueryOptions& options );
+	void enqueue( Job* pJob );
+
+public:
+	QueryExecutor( const GraphType& graph, int threads = 0, size_t maxInFlight = 1024, int numaNode = -1 );
+	~QueryExecutor();
+
+	future<Result> submit( int start, int goal, const QueryOptions& options = QueryOptions() );
+	future<Result> submit( int start, int goal, const Callback& callback, const QueryOptions& options = QueryOptions() );
+	void submitBatch( const vector< pair<int, int> >& queries, vector< future<Result> >& results, const QueryOptions& options = QueryOptions() );
+	void wait();
+
+	// queries queued or running right now.
+	size_t inFlight() {
+		lock_guard<mutex> guard( m_lock );
+		return m_inFlight;
+	}
+};
+
+// ----------------------------------------------------------------
+//  Name:           QueryExecutor
+//  Description:    Constructor, starts the worker threads.
+//  Arguments:      The first parameter is the graph to search.
+//                  The second parameter is the number of workers, or
+//                  0 for one per hardware thread.
+//                  The third parameter is the most queries that may be
+//                  queued or running at once.
+//                  The fourth parameter is the memory node to bind the
+//                  workers to, or -1 to let them run anywhere.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class GraphType, class ArcType>
+QueryExecutor<GraphType, ArcType>::QueryExecutor( const GraphType& graph, int threads, size_t maxInFlight, int numaNode ) :
+	m_graph( graph ), m_maxInFlight( maxInFlight > 0 ? maxInFlight : 1 ), m_inFlight( 0 ), m_stopping( false ) {
+	if( threads <= 0 ) {
+		threads = (int)thread::hardware_concurrency();
+		if( threads <= 0 ) {
+			threads = 1;
+		}
+	}
+	for( int i = 0; i < threads; i++ ) {
+		m_workers.push_back( thread( [this, numaNode]() {
+			if( numaNode >= 0 ) {
+				Numa::bindThread( numaNode );
+			}
+			work();
+		} ) );
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           ~QueryExecutor
+//  Description:    Destructor, finishes every submitted query and
+//                  then stops the workers.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class GraphType, class ArcType>
+QueryExecutor<GraphType, ArcType>::~QueryExecutor() {
+	{
+		lock_guard<mutex> guard( m_lock );
+		m_stopping = true;
+	}
+	m_ready.notify_all();
+	for( size_t i = 0; i < m_workers.size(); i++ ) {
+		m_workers[i].join();
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           work
+//  Description:    Worker loop: takes jobs off the queue and runs
+//                  them with the worker's own search state until the
+//                  executor stops and the queue is empty. If the
+//                  search or the callback throws, the query's future
+//                  holds the exception and the worker carries on.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class GraphType, class ArcType>
+void QueryExecutor<GraphType, ArcType>::work() {
+	SearchState<ArcType> state;
+	unique_lock<mutex> guard( m_lock );
+	for( ;; ) {
+		m_ready.wait( guard, [this]() {
+			return m_stopping == true || m_queue.size() != 0;
+		} );
+		if( m_queue.size() == 0 ) {
+			return;
+		}
+		Job* pJob = m_queue.front();
+		m_queue.pop_front();
+		guard.unlock();
+
+		// an exception from the search or the callback would end the
+		// process here, so it goes to the query's future instead.
+		try {
+			Result result;
+			QuerySummary<ArcType> summary = m_graph.boundedSearch( pJob->start, pJob->goal, pJob->options, state );
+			result.status = summary.status;
+			result.cost = summary.cost;
+			result.expansions = summary.expansions;
+			state.writePath( summary.end, result.path );
+			if( pJob->callback ) {
+				pJob->callback( result );
+			}
+			pJob->done.set_value( result );
+		}
+		catch( ... ) {
+			pJob->done.set_exception( current_exception() );
+		}
+		delete pJob;
+
+		guard.lock();
+		m_inFlight--;
+		// wakes both blocked submitters and anyone in wait().
+		m_space.notify_all();
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           onWorker
+//  Description:    Whether the calling thread is one of the workers,
+//                  that is, whether it is inside a callback.
+//  Arguments:      None.
+//  Return Value:   true on a worker thread.
+// ----------------------------------------------------------------
+template<class GraphType, class ArcType>
+bool QueryExecutor<GraphType, ArcType>::onWorker() const {
+	thread::id self = this_thread::get_id();
+	for( size_t i = 0; i < m_workers.size(); i++ ) {
+		if( m_workers[i].get_id() == self ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// ----------------------------------------------------------------
+//  Name:           makeJob
+//  Description:    Allocates a job for a query.
+//  Arguments:      The first and second parameters are the start and
+//                  goal node indices.
+//                  The third parameter holds the search limits.
+//  Return Value:   The new job.
+// ----------------------------------------------------------------
+template<class GraphType, class ArcType>
+typename QueryExecutor<GraphType, ArcType>::Job* QueryExecutor<GraphType, ArcType>::makeJob( int start, int goal, const QueryOptions& options ) {
+	Job* pJob = new Job;
+	pJob->start = start;
+	pJob->goal = goal;
+	pJob->options = options;
+	return pJob;
+}
+
+// ----------------------------------------------------------------
+//  Name:           enqueue
+//  Description:    Waits until there is room, then hands a job to
+//                  the workers. The job belongs to them from then on.
+//                  Jobs submitted from a callback don't wait, as the
+//                  room might only come from the worker that would be
+//                  waiting.
+//  Arguments:      The job.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class GraphType, class ArcType>
+void QueryExecutor<GraphType, ArcType>::enqueue( Job* pJob ) {
+	bool fromCallback = onWorker();
+	unique_lock<mutex> guard( m_lock );
+	m_space.wait( guard, [this, fromCallback]() {
+		return fromCallback == true || m_inFlight < m_maxInFlight;
+	} );
+	m_inFlight++;
+	m_queue.push_back( pJob );
+	m_ready.notify_one();
+}
+
+// ----------------------------------------------------------------
+//  Name:           submit
+//  Description:    Queues a search, waiting first if too many are
+//                  already in flight.
+//  Arguments:      The first and second parameters are the start and
+//                  goal node indices.
+//                  The third parameter holds the search limits.
+//  Return Value:   A future that becomes ready with the result.
+// ----------------------------------------------------------------
+template<class GraphType, class ArcType>
+future<QueryResult<ArcType> > QueryExecutor<GraphType, ArcType>::submit( int start, int goal, const QueryOptions& options ) {
+	Job* pJob = makeJob( start, goal, options );
+	// take the future before the job is visible to the workers.
+	future<Result> result = pJob->done.get_future();
+	enqueue( pJob );
+	return result;
+}
+
+// ----------------------------------------------------------------
+//  Name:           submit
+//  Description:    Queues a search whose result is handed to a
+//                  callback. The callback runs on a worker thread, so
+//                  it should be quick, e.g. post the result back to
+//                  the caller's event loop. It may submit more queries
+//                  but must not call wait().
+//  Arguments:      The first and second parameters are the start and
+//                  goal node indices.
+//                  The third parameter is called with the result.
+//                  The fourth parameter holds the search limits.
+//  Return Value:   A future that becomes ready once the callback has
+//                  run, with the result or whatever the callback
+//                  threw. It may be ignored.
+// ----------------------------------------------------------------
+template<class GraphType, class ArcType>
+future<QueryResult<ArcType> > QueryExecutor<GraphType, ArcType>::submit( int start, int goal, const Callback& callback, const QueryOptions& options ) {
+	Job* pJob = makeJob( start, goal, options );
+	pJob->callback = callback;
+	future<Result> result = pJob->done.get_future();
+	enqueue( pJob );
+	return result;
+}
+
+// ----------------------------------------------------------------
+//  Name:           submitBatch
+//  Description:    Queues many searches with the same limits. The
+//                  batch is fed in as room frees up, so it may be far
+//                  larger than the in-flight limit.
+//  Arguments:      The first parameter is the (start, goal) pairs.
+//                  The second parameter gets one future per query, in
+//                  the same order.
+//                  The third parameter holds the search limits.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class GraphType, class ArcType>
+void QueryExecutor<GraphType, ArcType>::submitBatch( const vector< pair<int, int> >& queries, vector< future<Result> >& results, const QueryOptions& options ) {
+	results.clear();
+	results.reserve( queries.size() );
+	for( size_t i = 0; i < queries.size(); i++ ) {
+		results.push_back( submit( queries[i].first, queries[i].second, options ) );
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           wait
+//  Description:    Blocks until every submitted query has completed.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class GraphType, class ArcType>
+void QueryExecutor<GraphType, ArcType>::wait() {
+	unique_lock<mutex> guard( m_lock );
+	m_space.wait( guard, [this]() {
+		return m_inFlight == 0;
+	} );
+}
+
+#endif
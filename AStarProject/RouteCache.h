@@ -0,0 +1,216 @@
+#ifndef ROUTECACHE_H
+#define ROUTECACHE_H
+
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+
+using namespace std;
+
+// ----------------------------------------------------------------
+//  Name:           RouteCache
+//  Description:    Thread-safe cache of finished routes, keyed by
+//                  start, goal and the graph version they were found
+//                  on. A change to the graph bumps its version, so old
+//                  routes are never matched again and simply age out.
+//                  The cache is split into shards, each with its own
+//                  lock, memory budget and least-recently-used list.
+// ----------------------------------------------------------------
+template<class ArcType>
+class RouteCache {
+private:
+	struct Key {
+		int start;
+		int goal;
+		unsigned int version;
+
+		bool operator==( const Key& other ) const {
+			return start == other.start && goal == other.goal && version == other.version;
+		}
+	};
+
+	struct KeyHash {
+		size_t operator()( const Key& key ) const {
+			size_t hash = (size_t)key.start * 2654435761u;
+			hash ^= (size_t)key.goal + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+			hash ^= (size_t)key.version + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+			return hash;
+		}
+	};
+
+	struct Entry {
+		Key key;
+		ArcType cost;
+		vector<int> path;
+	};
+
+	// ----------------------------------------------------------------
+	//  Description:    One shard: entries most recently used first,
+	//                  and a map from key to position in that list.
+	// ----------------------------------------------------------------
+	struct Shard {
+		mutex lock;
+		list<Entry> entries;
+		unordered_map<Key, typename list<Entry>::iterator, KeyHash> index;
+		size_t bytes;
+	};
+
+	Shard* m_shards;
+	int m_shardCount;
+	size_t m_shardBytes;
+
+	atomic<unsigned long long> m_hits;
+	atomic<unsigned long long> m_misses;
+	atomic<unsigned long long> m_evictions;
+
+	static size_t entryBytes( const Entry& entry ) {
+		// the entry, its list and map nodes, and the path itself.
+		return sizeof( Entry ) + 4 * sizeof( void* ) + entry.path.capacity() * sizeof( int );
+	}
+
+	// the shard comes from the top bits of the hash times a large odd
+	// constant, since the maps bucket by the low bits; taking those
+	// here too would leave each shard's map using a fraction of its
+	// buckets.
+	Shard& shardFor( const Key& key ) {
+		unsigned long long mixed = (unsigned long long)KeyHash()( key ) * 0x9e3779b97f4a7c15ULL;
+		return m_shards[(size_t)(mixed >> 32) % m_shardCount];
+	}
+
+public:
+	// ----------------------------------------------------------------
+	//  Name:           RouteCache
+	//  Description:    Constructor.
+	//  Arguments:      The first parameter is the total memory budget
+	//                  in bytes, split evenly between the shards.
+	//                  The second parameter is the number of shards.
+	//  Return Value:   None.
+	// ----------------------------------------------------------------
+	RouteCache( size_t maxBytes, int shards = 16 ) :
+		m_shardCount( shards > 0 ? shards : 1 ), m_hits( 0 ), m_misses( 0 ), m_evictions( 0 ) {
+		m_shards = new Shard[m_shardCount];
+		m_shardBytes = maxBytes / m_shardCount;
+		for( int i = 0; i < m_shardCount; i++ ) {
+			m_shards[i].bytes = 0;
+		}
+	}
+
+	~RouteCache() {
+		delete [] m_shards;
+	}
+
+	// ----------------------------------------------------------------
+	//  Name:           lookup
+	//  Description:    Finds a cached route and marks it as used.
+	//  Arguments:      The first and second parameters are the start
+	//                  and goal node indices.
+	//                  The third parameter is the current graph version.
+	//                  The fourth and fifth parameters are filled with
+	//                  the cost and the node indices from start to goal.
+	//  Return Value:   true if the route was cached.
+	// ----------------------------------------------------------------
+	bool lookup( int start, int goal, unsigned int version, ArcType& cost, vector<int>& path ) {
+		Key key = { start, goal, version };
+		Shard& shard = shardFor( key );
+		lock_guard<mutex> guard( shard.lock );
+
+		typename unordered_map<Key, typename list<Entry>::iterator, KeyHash>::iterator iter = shard.index.find( key );
+		if( iter == shard.index.end() ) {
+			m_misses++;
+			return false;
+		}
+		// move it to the front of the list.
+		shard.entries.splice( shard.entries.begin(), shard.entries, iter->second );
+		cost = iter->second->cost;
+		path.assign( iter->second->path.begin(), iter->second->path.end() );
+		m_hits++;
+		return true;
+	}
+
+	// ----------------------------------------------------------------
+	//  Name:           store
+	//  Description:    Adds a route, evicting the least recently used
+	//                  routes of its shard until it fits.
+	//  Arguments:      The first and second parameters are the start
+	//                  and goal node indices.
+	//                  The third parameter is the graph version the
+	//                  route was found on.
+	//                  The fourth and fifth parameters are the cost and
+	//                  the node indices from start to goal.
+	//  Return Value:   None.
+	// ----------------------------------------------------------------
+	void store( int start, int goal, unsigned int version, ArcType cost, const vector<int>& path ) {
+		Entry entry;
+		entry.key.start = start;
+		entry.key.goal = goal;
+		entry.key.version = version;
+		entry.cost = cost;
+		entry.path = path;
+		size_t bytes = entryBytes( entry );
+
+		Shard& shard = shardFor( entry.key );
+		lock_guard<mutex> guard( shard.lock );
+		if( bytes > m_shardBytes || shard.index.find( entry.key ) != shard.index.end() ) {
+			return;
+		}
+		while( shard.bytes + bytes > m_shardBytes ) {
+			shard.bytes -= entryBytes( shard.entries.back() );
+			shard.index.erase( shard.entries.back().key );
+			shard.entries.pop_back();
+			m_evictions++;
+		}
+
+		shard.entries.push_front( Entry() );
+		shard.entries.front().key = entry.key;
+		shard.entries.front().cost = cost;
+		shard.entries.front().path.swap( entry.path );
+		shard.index[entry.key] = shard.entries.begin();
+		shard.bytes += bytes;
+	}
+
+	// ----------------------------------------------------------------
+	//  Name:           clear
+	//  Description:    Removes every route. The counters are kept.
+	//  Arguments:      None.
+	//  Return Value:   None.
+	// ----------------------------------------------------------------
+	void clear() {
+		for( int i = 0; i < m_shardCount; i++ ) {
+			lock_guard<mutex> guard( m_shards[i].lock );
+			m_shards[i].entries.clear();
+			m_shards[i].index.clear();
+			m_shards[i].bytes = 0;
+		}
+	}
+
+	unsigned long long hits() const {
+		return m_hits;
+	}
+
+	unsigned long long misses() const {
+		return m_misses;
+	}
+
+	unsigned long long evictions() const {
+		return m_evictions;
+	}
+
+	// ----------------------------------------------------------------
+	//  Name:           bytesUsed
+	//  Description:    Estimated memory held by the cached routes.
+	//  Arguments:      None.
+	//  Return Value:   The size in bytes.
+	// ----------------------------------------------------------------
+	size_t bytesUsed() {
+		size_t total = 0;
+		for( int i = 0; i < m_shardCount; i++ ) {
+			lock_guard<mutex> guard( m_shards[i].lock );
+			total += m_shards[i].bytes;
+		}
+		return total;
+	}
+};
+
+#endif
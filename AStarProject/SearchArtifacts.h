@@ -0,0 +1,567 @@
+#ifndef SEARCHARTIFACTS_H
+#define SEARCHARTIFACTS_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+
+#if defined( _WIN32 )
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Graph.h"
+
+// ----------------------------------------------------------------
+//  Description:    Search data derived from a graph, saved to a file
+//                  so it needn't be recomputed at every start. The
+//                  file is tied to the graph it was built from by a
+//                  hash of the graph's contents, and is refused when
+//                  the graph has changed since (say Arcs.txt was
+//                  edited). The format, with every integer in the
+//                  byte order of the machine that wrote it:
+//
+//                  "ASRA", format version, graph hash (8 bytes),
+//                  section count, byte order mark (0x01020304), then
+//                  for each section: id, element size, offset, byte
+//                  count (4, 4, 8 and 8 bytes), then the sections'
+//                  data, each starting on a 64 byte boundary.
+//
+//                  Loading maps the file into memory rather than
+//                  reading it, so a section is only paged in when it
+//                  is used and large tables can be searched in place.
+//                  That is why the data stays in the machine's own
+//                  order; a file from a machine of the other order is
+//                  refused by its byte order mark and rebuilt.
+// ----------------------------------------------------------------
+const unsigned int ARTIFACT_FILE_VERSION = 2;
+const unsigned int ARTIFACT_BYTE_ORDER = 0x01020304;
+
+// section ids. Ids from ARTIFACT_USER up are free for other data,
+// such as landmark distance tables or hierarchy shortcuts.
+enum ArtifactSection {
+	ARTIFACT_WEAK_COMPONENTS = 1,	// int per node, see Graph::componentLabels
+	ARTIFACT_STRONG_COMPONENTS = 2,	// int per node
+	ARTIFACT_NODE_HEURISTICS = 3,	// int per node, see GraphNode::setHeuristic
+	ARTIFACT_USER = 0x1000
+};
+
+// what SearchArtifacts::open found.
+enum ArtifactStatus {
+	ARTIFACT_OK,
+	ARTIFACT_MISSING,		// no such file
+	ARTIFACT_CORRUPT,		// not an artifact file, or cut short
+	ARTIFACT_OLD_VERSION,	// written by a different format version
+	ARTIFACT_STALE,			// built from a different graph
+	ARTIFACT_FOREIGN		// written on a machine of the other byte order
+};
+
+// ----------------------------------------------------------------
+//  Name:           graphHash
+//  Description:    64-bit FNV-1a hash of everything a search sees in
+//                  a graph: its size, the arc type, and each node's
+//                  index, position and arcs (targets and weights) in
+//                  order. Names and other node data are left out.
+//                  Reordering the graph changes the hash, since saved
+//                  data is indexed by the current node indices.
+//  Arguments:      The graph.
+//  Return Value:   The hash.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+unsigned long long graphHash( const Graph<NodeType, ArcType>& graph ) {
+	typedef GraphArc<NodeType, ArcType> Arc;
+	struct Hasher {
+		unsigned long long value;
+
+		void add( const void* pData, size_t bytes ) {
+			const unsigned char* pByte = (const unsigned char*)pData;
+			for( size_t i = 0; i < bytes; i++ ) {
+				value = (value ^ pByte[i]) * 1099511628211ULL;
+			}
+		}
+	};
+
+	Hasher hash;
+	hash.value = 14695981039346656037ULL;
+	int fields[4] = { graph.maxSize(), (int)sizeof( ArcType ), 0, 0 };
+	hash.add( fields, 2 * sizeof( int ) );
+	for( int i = 0; i < graph.maxSize(); i++ ) {
+		GraphNode<NodeType, ArcType>* pNode = graph.nodeArray()[i];
+		if( pNode == 0 ) {
+			continue;
+		}
+		fields[0] = i;
+		fields[1] = pNode->getX();
+		fields[2] = pNode->getY();
+		fields[3] = (int)pNode->arcList().size();
+		hash.add( fields, sizeof( fields ) );
+
+		typename list<Arc>::const_iterator iter = pNode->arcList().begin();
+		typename list<Arc>::const_iterator endIter = pNode->arcList().end();
+		for( ; iter != endIter; ++iter ) {
+			int to = (*iter).node()->getIndex();
+			ArcType weight = (*iter).weight();
+			hash.add( &to, sizeof( int ) );
+			hash.add( &weight, sizeof( ArcType ) );
+		}
+	}
+	return hash.value;
+}
+
+// ----------------------------------------------------------------
+//  Name:           ArtifactWriter
+//  Description:    Collects sections and writes an artifact file.
+// ----------------------------------------------------------------
+class ArtifactWriter {
+private:
+	struct Section {
+		unsigned int id;
+		unsigned int elementSize;
+		vector<unsigned char> data;
+	};
+
+	vector<Section> m_sections;
+
+public:
+	// ----------------------------------------------------------------
+	//  Name:           add
+	//  Description:    Adds a section, replacing any with the same id.
+	//  Arguments:      The first parameter is the section id.
+	//                  The second and third parameters are the data
+	//                  and its size in bytes, copied in.
+	//                  The fourth parameter is the size of one element,
+	//                  checked when the section is read back.
+	//  Return Value:   None.
+	// ----------------------------------------------------------------
+	void add( unsigned int id, const void* pData, size_t bytes, unsigned int elementSize = 1 ) {
+		size_t i = 0;
+		while( i < m_sections.size() && m_sections[i].id != id ) {
+			i++;
+		}
+		if( i == m_sections.size() ) {
+			m_sections.push_back( Section() );
+		}
+		m_sections[i].id = id;
+		m_sections[i].elementSize = elementSize;
+		m_sections[i].data.assign( (const unsigned char*)pData, (const unsigned char*)pData + bytes );
+	}
+
+	template<class T>
+	void addArray( unsigned int id, const vector<T>& values ) {
+		add( id, values.empty() ? 0 : &values[0], values.size() * sizeof( T ), sizeof( T ) );
+	}
+
+	// ----------------------------------------------------------------
+	//  Name:           addComponentLabels
+	//  Description:    Adds the graph's connectivity index.
+	//  Arguments:      The graph.
+	//  Return Value:   false if the graph's index isn't built.
+	// ----------------------------------------------------------------
+	template<class NodeType, class ArcType>
+	bool addComponentLabels( const Graph<NodeType, ArcType>& graph ) {
+		vector<int> weak;
+		vector<int> strong;
+		if( graph.componentLabels( weak, strong ) == false ) {
+			return false;
+		}
+		addArray( ARTIFACT_WEAK_COMPONENTS, weak );
+		addArray( ARTIFACT_STRONG_COMPONENTS, strong );
+		return true;
+	}
+
+	// ----------------------------------------------------------------
+	//  Name:           addHeuristics
+	//  Description:    Adds every node's heuristic value, 0 for no node.
+	//  Arguments:      The graph.
+	//  Return Value:   None.
+	// ----------------------------------------------------------------
+	template<class NodeType, class ArcType>
+	void addHeuristics( const Graph<NodeType, ArcType>& graph ) {
+		vector<int> values( graph.maxSize(), 0 );
+		for( int i = 0; i < graph.maxSize(); i++ ) {
+			if( graph.nodeArray()[i] != 0 ) {
+				values[i] = graph.nodeArray()[i]->getHeuristic();
+			}
+		}
+		addArray( ARTIFACT_NODE_HEURISTICS, values );
+	}
+
+	// ----------------------------------------------------------------
+	//  Name:           save
+	//  Description:    Writes the sections to a file. They are written
+	//                  to the file's name plus ".tmp" first and then
+	//                  renamed over it, so a reader (or a crash) never
+	//                  sees a file half written. On Windows the rename
+	//                  fails while another process has the old file
+	//                  open; elsewhere that process keeps the old one.
+	//  Arguments:      The first parameter is the file to write.
+	//                  The second parameter is the graphHash of the
+	//                  graph the sections were built from.
+	//  Return Value:   true if the file was replaced. If not, the old
+	//                  file is left as it was.
+	// ----------------------------------------------------------------
+	bool save( const string& file, unsigned long long hash ) const {
+		string temporary = file + ".tmp";
+		bool written = write( temporary, hash );
+#if defined( _WIN32 )
+		if( written == true && MoveFileExA( temporary.c_str(), file.c_str(), MOVEFILE_REPLACE_EXISTING ) != FALSE ) {
+			return true;
+		}
+#else
+		if( written == true && rename( temporary.c_str(), file.c_str() ) == 0 ) {
+			return true;
+		}
+#endif
+		remove( temporary.c_str() );
+		return false;
+	}
+
+private:
+	// writes the whole file; save puts it in place.
+	bool write( const string& file, unsigned long long hash ) const {
+		ofstream out( file.c_str(), ios::binary );
+		if( !out ) {
+			return false;
+		}
+
+		unsigned int header[6] = { 0, ARTIFACT_FILE_VERSION, 0, 0, (unsigned int)m_sections.size(), ARTIFACT_BYTE_ORDER };
+		memcpy( &header[0], "ASRA", 4 );
+		memcpy( &header[2], &hash, sizeof( hash ) );
+		out.write( (const char*)header, sizeof( header ) );
+
+		unsigned long long offset = sizeof( header ) + m_sections.size() * 24;
+		for( size_t i = 0; i < m_sections.size(); i++ ) {
+			offset = (offset + 63) / 64 * 64;
+			unsigned long long bytes = m_sections[i].data.size();
+			unsigned int ids[2] = { m_sections[i].id, m_sections[i].elementSize };
+			out.write( (const char*)ids, sizeof( ids ) );
+			out.write( (const char*)&offset, sizeof( offset ) );
+			out.write( (const char*)&bytes, sizeof( bytes ) );
+			offset += bytes;
+		}
+
+		static const char padding[64] = { 0 };
+		unsigned long long at = sizeof( header ) + m_sections.size() * 24;
+		for( size_t i = 0; i < m_sections.size(); i++ ) {
+			unsigned long long start = (at + 63) / 64 * 64;
+			out.write( padding, (streamsize)(start - at) );
+			if( m_sections[i].data.empty() == false ) {
+				out.write( (const char*)&m_sections[i].data[0], (streamsize)m_sections[i].data.size() );
+			}
+			at = start + m_sections[i].data.size();
+		}
+		out.close();
+		return out.good();
+	}
+};
+
+// ----------------------------------------------------------------
+//  Name:           SearchArtifacts
+//  Description:    An artifact file mapped into memory. Sections are
+//                  read in place and stay valid until the file is
+//                  closed.
+// ----------------------------------------------------------------
+class SearchArtifacts {
+private:
+	const unsigned char* m_pData;
+	size_t m_size;
+#if defined( _WIN32 )
+	HANDLE m_file;
+	HANDLE m_mapping;
+#endif
+
+	// not copyable.
+	SearchArtifacts( const SearchArtifacts& );
+	SearchArtifacts& operator=( const SearchArtifacts& );
+
+	bool mapFile( const string& file );
+	ArtifactStatus check( unsigned long long hash ) const;
+
+public:
+	SearchArtifacts() : m_pData( 0 ), m_size( 0 ) {
+#if defined( _WIN32 )
+		m_file = INVALID_HANDLE_VALUE;
+		m_mapping = 0;
+#endif
+	}
+
+	~SearchArtifacts() {
+		close();
+	}
+
+	ArtifactStatus open( const string& file, unsigned long long hash );
+	void close();
+	const void* section( unsigned int id, size_t& bytes ) const;
+
+	// ----------------------------------------------------------------
+	//  Name:           array
+	//  Description:    A section as an array of T.
+	//  Arguments:      The first parameter is the section id.
+	//                  The second parameter gets the number of elements.
+	//  Return Value:   The array, or 0 if there is no such section or
+	//                  it wasn't saved as an array of T.
+	// ----------------------------------------------------------------
+	template<class T>
+	const T* array( unsigned int id, size_t& count ) const {
+		count = 0;
+		size_t bytes;
+		const void* pData = section( id, bytes );
+		if( pData == 0 || elementSize( id ) != sizeof( T ) ) {
+			return 0;
+		}
+		count = bytes / sizeof( T );
+		return (const T*)pData;
+	}
+
+	unsigned int elementSize( unsigned int id ) const;
+
+	template<class NodeType, class ArcType>
+	bool loadComponentLabels( Graph<NodeType, ArcType>& graph ) const;
+	template<class NodeType, class ArcType>
+	bool loadHeuristics( Graph<NodeType, ArcType>& graph ) const;
+};
+
+// ----------------------------------------------------------------
+//  Name:           open
+//  Description:    Maps an artifact file and checks it belongs to
+//                  the graph. Any file already open is closed first.
+//  Arguments:      The first parameter is the file.
+//                  The second parameter is the graphHash of the
+//                  graph being searched.
+//  Return Value:   ARTIFACT_OK if the sections can be used; otherwise
+//                  why not, and the file is left closed.
+// ----------------------------------------------------------------
+inline ArtifactStatus SearchArtifacts::open( const string& file, unsigned long long hash ) {
+	close();
+	if( mapFile( file ) == false ) {
+		return ARTIFACT_MISSING;
+	}
+	ArtifactStatus status = check( hash );
+	if( status != ARTIFACT_OK ) {
+		close();
+	}
+	return status;
+}
+
+// ----------------------------------------------------------------
+//  Name:           mapFile
+//  Description:    Maps a whole file read-only.
+//  Arguments:      The file.
+//  Return Value:   false if it can't be opened or mapped.
+// ----------------------------------------------------------------
+inline bool SearchArtifacts::mapFile( const string& file ) {
+#if defined( _WIN32 )
+	m_file = CreateFileA( file.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0 );
+	LARGE_INTEGER size;
+	if( m_file == INVALID_HANDLE_VALUE || GetFileSizeEx( m_file, &size ) == FALSE || size.QuadPart == 0 ) {
+		close();
+		return false;
+	}
+	m_mapping = CreateFileMappingA( m_file, 0, PAGE_READONLY, 0, 0, 0 );
+	if( m_mapping == 0 ) {
+		close();
+		return false;
+	}
+	m_pData = (const unsigned char*)MapViewOfFile( m_mapping, FILE_MAP_READ, 0, 0, 0 );
+	if( m_pData == 0 ) {
+		close();
+		return false;
+	}
+	m_size = (size_t)size.QuadPart;
+	return true;
+#else
+	int descriptor = ::open( file.c_str(), O_RDONLY );
+	if( descriptor < 0 ) {
+		return false;
+	}
+	struct stat info;
+	if( fstat( descriptor, &info ) != 0 || info.st_size == 0 ) {
+		::close( descriptor );
+		return false;
+	}
+	void* pData = mmap( 0, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0 );
+	// the mapping keeps the file open.
+	::close( descriptor );
+	if( pData == MAP_FAILED ) {
+		return false;
+	}
+	m_pData = (const unsigned char*)pData;
+	m_size = (size_t)info.st_size;
+	return true;
+#endif
+}
+
+// ----------------------------------------------------------------
+//  Name:           close
+//  Description:    Unmaps the file. Sections read from it are no
+//                  longer valid.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+inline void SearchArtifacts::close() {
+#if defined( _WIN32 )
+	if( m_pData != 0 ) {
+		UnmapViewOfFile( m_pData );
+	}
+	if( m_mapping != 0 ) {
+		CloseHandle( m_mapping );
+	}
+	if( m_file != INVALID_HANDLE_VALUE ) {
+		CloseHandle( m_file );
+	}
+	m_file = INVALID_HANDLE_VALUE;
+	m_mapping = 0;
+#else
+	if( m_pData != 0 ) {
+		munmap( (void*)m_pData, m_size );
+	}
+#endif
+	m_pData = 0;
+	m_size = 0;
+}
+
+// ----------------------------------------------------------------
+//  Name:           check
+//  Description:    Checks the header and that every section lies
+//                  within the file.
+//  Arguments:      The graph hash expected.
+//  Return Value:   What was found.
+// ----------------------------------------------------------------
+inline ArtifactStatus SearchArtifacts::check( unsigned long long hash ) const {
+	unsigned int header[6];
+	if( m_size < sizeof( header ) ) {
+		return ARTIFACT_CORRUPT;
+	}
+	memcpy( header, m_pData, sizeof( header ) );
+	if( memcmp( &header[0], "ASRA", 4 ) != 0 ) {
+		return ARTIFACT_CORRUPT;
+	}
+	// the mark comes first, as every other field reads swapped too.
+	if( header[5] == 0x04030201 ) {
+		return ARTIFACT_FOREIGN;
+	}
+	if( header[1] != ARTIFACT_FILE_VERSION ) {
+		return ARTIFACT_OLD_VERSION;
+	}
+	if( header[5] != ARTIFACT_BYTE_ORDER ) {
+		return ARTIFACT_CORRUPT;
+	}
+	unsigned long long saved;
+	memcpy( &saved, &header[2], sizeof( saved ) );
+	if( saved != hash ) {
+		return ARTIFACT_STALE;
+	}
+
+	unsigned long long count = header[4];
+	if( (m_size - sizeof( header )) / 24 < count ) {
+		return ARTIFACT_CORRUPT;
+	}
+	for( unsigned long long i = 0; i < count; i++ ) {
+		unsigned long long entry[2];
+		memcpy( entry, m_pData + sizeof( header ) + i * 24 + 8, sizeof( entry ) );
+		if( entry[0] > m_size || entry[1] > m_size - entry[0] ) {
+			return ARTIFACT_CORRUPT;
+		}
+	}
+	return ARTIFACT_OK;
+}
+
+// ----------------------------------------------------------------
+//  Name:           section
+//  Description:    Finds a section in the mapped file.
+//  Arguments:      The first parameter is the section id.
+//                  The second parameter gets its size in bytes.
+//  Return Value:   The section's data, or 0 if there is none.
+// ----------------------------------------------------------------
+inline const void* SearchArtifacts::section( unsigned int id, size_t& bytes ) const {
+	bytes = 0;
+	if( m_pData == 0 ) {
+		return 0;
+	}
+	unsigned int count;
+	memcpy( &count, m_pData + 16, sizeof( count ) );
+	for( unsigned int i = 0; i < count; i++ ) {
+		const unsigned char* pEntry = m_pData + 24 + i * 24;
+		unsigned int entryId;
+		memcpy( &entryId, pEntry, sizeof( entryId ) );
+		if( entryId == id ) {
+			unsigned long long location[2];
+			memcpy( location, pEntry + 8, sizeof( location ) );
+			bytes = (size_t)location[1];
+			return m_pData + location[0];
+		}
+	}
+	return 0;
+}
+
+// the element size a section was saved with, 0 if it is missing.
+inline unsigned int SearchArtifacts::elementSize( unsigned int id ) const {
+	if( m_pData == 0 ) {
+		return 0;
+	}
+	unsigned int count;
+	memcpy( &count, m_pData + 16, sizeof( count ) );
+	for( unsigned int i = 0; i < count; i++ ) {
+		unsigned int ids[2];
+		memcpy( ids, m_pData + 24 + i * 24, sizeof( ids ) );
+		if( ids[0] == id ) {
+			return ids[1];
+		}
+	}
+	return 0;
+}
+
+// ----------------------------------------------------------------
+//  Name:           loadComponentLabels
+//  Description:    Restores the graph's connectivity index from the
+//                  file, in place of Graph::buildComponents.
+//  Arguments:      The graph.
+//  Return Value:   false if the file has no usable labels.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+bool SearchArtifacts::loadComponentLabels( Graph<NodeType, ArcType>& graph ) const {
+	size_t weakCount;
+	size_t strongCount;
+	const int* pWeak = array<int>( ARTIFACT_WEAK_COMPONENTS, weakCount );
+	const int* pStrong = array<int>( ARTIFACT_STRONG_COMPONENTS, strongCount );
+	if( pWeak == 0 || pStrong == 0 || weakCount != strongCount ) {
+		return false;
+	}
+	return graph.setComponentLabels( pWeak, pStrong, (int)weakCount );
+}
+
+// ----------------------------------------------------------------
+//  Name:           loadHeuristics
+//  Description:    Sets every node's heuristic value from the file.
+//  Arguments:      The graph.
+//  Return Value:   false if the file has no heuristics for a graph
+//                  of this size.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+bool SearchArtifacts::loadHeuristics( Graph<NodeType, ArcType>& graph ) const {
+	size_t count;
+	const int* pValues = array<int>( ARTIFACT_NODE_HEURISTICS, count );
+	if( pValues == 0 || (int)count != graph.maxSize() ) {
+		return false;
+	}
+	for( int i = 0; i < graph.maxSize(); i++ ) {
+		if( graph.nodeArray()[i] != 0 ) {
+			graph.nodeArray()[i]->setHeuristic( pValues[i] );
+		}
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,732 @@
+// ----------------------------------------------------------------
+//  SearchChecks: checks and benchmarks for the search code, kept
+//  apart from BatchRouter so the router only routes. Each run loads
+//  a graph the same way BatchRouter does, reads "start goal" pairs
+//  from a file or standard input, and does one of:
+//
+//  --reorder-bench times the queries on the graph as loaded and after
+//  each node ordering, to show what BatchRouter's --reorder is worth
+//  on a graph.
+//
+//  --numa-bench copies the compressed graph to every memory node and
+//  times each node against the shared copy and its own.
+//
+//  --hierarchical plans every query with hierarchical path-finding,
+//  checks each route against the graph and the exact search, and
+//  compares the time and memory each takes.
+//
+//  --engine-check times each open list, estimate and search state and
+//  checks that they all find the cheapest routes.
+//
+//  --k-shortest-check checks KShortestPaths against a brute force
+//  search on small random graphs, and needs no graph or queries.
+//
+//  Results go to standard error. The exit status is 1 if a check
+//  found a wrong answer.
+// ----------------------------------------------------------------
+#define GRAPH_NO_SFML
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+#include "Graph.h"
+#include "GraphIO.h"
+#include "CompressedGraph.h"
+#include "QueryExecutor.h"
+#include "NumaReplica.h"
+#include "HierarchicalGraph.h"
+#include "KShortestPaths.h"
+#include "LatencyHistogram.h"
+
+using namespace std;
+
+typedef Graph<pair<string, int>, int> MapGraph;
+typedef GraphArc<pair<string, int>, int> MapArc;
+typedef chrono::steady_clock Clock;
+
+// ----------------------------------------------------------------
+//  Name:           Options
+//  Description:    Command line settings.
+// ----------------------------------------------------------------
+struct Options {
+	string nodesFile;
+	string arcsFile;
+	string binaryFile;
+	string queriesFile;
+	bool fileWeights;
+	bool compressed;
+	bool hugePages;
+	bool numaBench;
+	bool reorderBench;
+	bool engineCheck;
+	int threads;
+	int window;
+	int maxExpansions;
+	int clusterSize;
+	int kShortestTrials;
+
+	Options() : nodesFile( "Nodes.txt" ), arcsFile( "Arcs.txt" ), fileWeights( false ), compressed( false ), hugePages( false ),
+		numaBench( false ), reorderBench( false ), engineCheck( false ), threads( 0 ), window( 256 ), maxExpansions( 0 ), clusterSize( 0 ), kShortestTrials( 0 ) {
+	}
+};
+
+// ----------------------------------------------------------------
+//  Name:           readQueries
+//  Description:    Reads every query up front for the benchmarks,
+//                  dropping any that name no node.
+//  Arguments:      The first parameter is the loaded graph.
+//                  The second parameter is the query input.
+//                  The third parameter is filled with the queries, as
+//                  the node numbers in the input.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+void readQueries( const MapGraph& graph, istream& input, vector< pair<int, int> >& queries ) {
+	int start, goal;
+	while( input >> start >> goal ) {
+		if( start >= 0 && goal >= 0 && start < graph.maxSize() && goal < graph.maxSize() &&
+			graph.nodeArray()[graph.internalIndex( start )] != 0 && graph.nodeArray()[graph.internalIndex( goal )] != 0 ) {
+			queries.push_back( make_pair( start, goal ) );
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           timeQueries
+//  Description:    Runs every query on one node's workers and times
+//                  them.
+//  Arguments:      The first parameter is the graph to search.
+//                  The second parameter is the node to run on.
+//                  The third parameter is the workers to use.
+//                  The fourth parameter is the queries.
+//                  The fifth parameter holds the settings.
+//  Return Value:   The queries per second.
+// ----------------------------------------------------------------
+double timeQueries( const CompressedGraph<int>& searchGraph, int node, int threads, const vector< pair<int, int> >& queries, const Options& options ) {
+	QueryOptions limits;
+	limits.maxExpansions = options.maxExpansions;
+	Clock::time_point start = Clock::now();
+	{
+		QueryExecutor<CompressedGraph<int>, int> executor( searchGraph, threads, options.window, node );
+		QueryExecutor<CompressedGraph<int>, int>::Callback ignore = []( const QueryResult<int>& ) {
+		};
+		for( size_t i = 0; i < queries.size(); i++ ) {
+			executor.submit( queries[i].first, queries[i].second, ignore, limits );
+		}
+		executor.wait();
+	}
+	double seconds = chrono::duration<double>( Clock::now() - start ).count();
+	return seconds > 0 ? queries.size() / seconds : 0;
+}
+
+// ----------------------------------------------------------------
+//  Name:           numaBench
+//  Description:    Runs the queries on each node in turn, first
+//                  against the single shared copy of the graph (which
+//                  sits on whichever node loaded it) and then against
+//                  the node's own copy, and reports the throughput of
+//                  each.
+//  Arguments:      The first parameter is the shared graph.
+//                  The second parameter is the per-node copies.
+//                  The third parameter is the loaded graph, for
+//                  checking and translating indices.
+//                  The fourth parameter is the query input.
+//                  The fifth parameter holds the settings.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+void numaBench( const CompressedGraph<int>& shared, const NumaReplicas<int>& replicas, const MapGraph& graph, istream& input, const Options& options ) {
+	vector< pair<int, int> > queries;
+	readQueries( graph, input, queries );
+	for( size_t i = 0; i < queries.size(); i++ ) {
+		queries[i] = make_pair( graph.internalIndex( queries[i].first ), graph.internalIndex( queries[i].second ) );
+	}
+
+	int threads = options.threads > 0 ? options.threads : (int)thread::hardware_concurrency();
+	threads = max( 1, threads / replicas.count() );
+	cerr << queries.size() << " queries, " << threads << " workers per node" << endl;
+	for( int i = 0; i < replicas.count(); i++ ) {
+		int node = replicas.nodeId( i );
+		double sharedRate = timeQueries( shared, node, threads, queries, options );
+		double localRate = timeQueries( replicas.replica( i ), node, threads, queries, options );
+		cerr << "node " << node << ": shared " << sharedRate << " queries/s, local copy " << localRate << " queries/s (" <<
+			(replicas.hugePages( i ) == true ? "huge pages" : "normal pages") << "), x" <<
+			(sharedRate > 0 ? localRate / sharedRate : 0) << endl;
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           timeOrdering
+//  Description:    Runs every query one after another on one thread
+//                  and reports the latency, so the only difference
+//                  between orderings is how the memory is laid out.
+//  Arguments:      The first parameter names the ordering.
+//                  The second parameter is the graph to search.
+//                  The third parameter is the loaded graph, for
+//                  translating indices.
+//                  The fourth parameter is the queries, as the node
+//                  numbers in the input.
+//                  The fifth parameter holds the settings.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class SearchGraph>
+void timeOrdering( const string& name, const SearchGraph& searchGraph, const MapGraph& graph, const vector< pair<int, int> >& queries, const Options& options ) {
+	QueryOptions limits;
+	limits.maxExpansions = options.maxExpansions;
+	SearchState<int> state;
+	LatencyHistogram latency;
+	long long expansions = 0;
+
+	// one untimed pass so every ordering starts with a warm cache.
+	for( size_t i = 0; i < queries.size(); i++ ) {
+		searchGraph.boundedSearch( graph.internalIndex( queries[i].first ), graph.internalIndex( queries[i].second ), limits, state );
+	}
+	Clock::time_point start = Clock::now();
+	for( size_t i = 0; i < queries.size(); i++ ) {
+		Clock::time_point queryStart = Clock::now();
+		QuerySummary<int> summary = searchGraph.boundedSearch( graph.internalIndex( queries[i].first ), graph.internalIndex( queries[i].second ), limits, state );
+		latency.add( chrono::duration<double, micro>( Clock::now() - queryStart ).count() );
+		expansions += summary.expansions;
+	}
+	double seconds = chrono::duration<double>( Clock::now() - start ).count();
+	cerr << name << ": mean " << (queries.size() > 0 ? seconds * 1e6 / queries.size() : 0) << " us, p50 " << latency.percentile( 0.5 ) <<
+		", p99 " << latency.percentile( 0.99 ) << ", " << expansions << " expansions" << endl;
+}
+
+// ----------------------------------------------------------------
+//  Name:           reorderBench
+//  Description:    Times the queries on the graph as loaded and then
+//                  after renumbering it in each ordering in turn. The
+//                  searches expand the same nodes, give or take ties
+//                  broken differently; only the memory layout, and so
+//                  the cache misses, change.
+//  Arguments:      The first parameter is the loaded graph, which is
+//                  left in the last ordering.
+//                  The second parameter is the query input.
+//                  The third parameter holds the settings.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+void reorderBench( MapGraph& graph, istream& input, const Options& options ) {
+	static const char* names[3] = { "hilbert", "bfs", "rcm" };
+	static const MapGraph::Ordering orderings[3] = { MapGraph::HILBERT_ORDER, MapGraph::BFS_ORDER, MapGraph::RCM_ORDER };
+	vector< pair<int, int> > queries;
+	readQueries( graph, input, queries );
+	cerr << queries.size() << " queries on one thread, " << (options.compressed == true ? "compressed" : "node") << " graph" << endl;
+
+	for( int i = -1; i < 3; i++ ) {
+		string name = "as loaded";
+		if( i >= 0 ) {
+			Clock::time_point start = Clock::now();
+			graph.reorder( orderings[i] );
+			name = names[i];
+			cerr << name << " ordering took " << chrono::duration<double>( Clock::now() - start ).count() << " s" << endl;
+		}
+		graph.buildComponents();
+		if( options.compressed == true ) {
+			CompressedGraph<int> packed;
+			packed.build( graph );
+			timeOrdering( name, packed, graph, queries, options );
+		}
+		else {
+			timeOrdering( name, graph, graph, queries, options );
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           hierarchicalCheck
+//  Description:    Plans every query through a HierarchicalGraph and
+//                  checks what comes back: the waypoints must run
+//                  from the start to the goal, every segment must
+//                  refine into arcs of the graph, the arcs must add up
+//                  to the cost reported, and the cost can't beat the
+//                  exact search's. Reports how many routes failed and
+//                  how much longer than the best the rest were, and
+//                  the latency and extra memory of planning, of
+//                  refining the whole route and of the flat search.
+//  Arguments:      The first parameter is the loaded graph.
+//                  The second parameter is the query input.
+//                  The third parameter holds the settings.
+//  Return Value:   The number of routes that failed.
+// ----------------------------------------------------------------
+int hierarchicalCheck( MapGraph& graph, istream& input, const Options& options ) {
+	vector< pair<int, int> > queries;
+	readQueries( graph, input, queries );
+	graph.buildComponents();
+	Clock::time_point built = Clock::now();
+	HierarchicalGraph<pair<string, int>, int> hierarchy( graph, options.clusterSize );
+	double buildSeconds = chrono::duration<double>( Clock::now() - built ).count();
+
+	SearchState<int> state;
+	LatencyHistogram flatLatency;
+	LatencyHistogram planLatency;
+	LatencyHistogram refineLatency;
+	vector<int> waypoints;
+	vector<int> segment;
+	int found = 0;
+	int failed = 0;
+	double excess = 0;
+	for( size_t q = 0; q < queries.size(); q++ ) {
+		int start = graph.internalIndex( queries[q].first );
+		int goal = graph.internalIndex( queries[q].second );
+		Clock::time_point clock = Clock::now();
+		QuerySummary<int> exact = graph.boundedSearch( start, goal, QueryOptions(), state );
+		flatLatency.add( chrono::duration<double, micro>( Clock::now() - clock ).count() );
+
+		int cost;
+		clock = Clock::now();
+		bool planned = hierarchy.findPath( start, goal, waypoints, cost );
+		planLatency.add( chrono::duration<double, micro>( Clock::now() - clock ).count() );
+		clock = Clock::now();
+		for( size_t i = 0; planned == true && i + 1 < waypoints.size(); i++ ) {
+			hierarchy.refineSegment( waypoints, (int)i, segment );
+		}
+		refineLatency.add( chrono::duration<double, micro>( Clock::now() - clock ).count() );
+		bool ok = planned == (exact.status == QUERY_FOUND);
+		if( planned == true && ok == true ) {
+			ok = waypoints.front() == start && waypoints.back() == goal && cost >= exact.cost;
+			int length = 0;
+			for( size_t i = 0; ok == true && i + 1 < waypoints.size(); i++ ) {
+				ok = hierarchy.refineSegment( waypoints, (int)i, segment ) == true &&
+					segment.front() == waypoints[i] && segment.back() == waypoints[i + 1];
+				for( size_t j = 0; ok == true && j + 1 < segment.size(); j++ ) {
+					GraphArc<pair<string, int>, int>* pArc = graph.getArc( segment[j], segment[j + 1] );
+					ok = pArc != 0;
+					length += ok == true ? pArc->weight() : 0;
+				}
+			}
+			ok = ok == true && length == cost;
+			if( ok == true ) {
+				found++;
+				excess += exact.cost > 0 ? (double)(cost - exact.cost) / exact.cost : 0;
+			}
+		}
+		if( ok == false ) {
+			failed++;
+			cerr << "query " << q << " (" << queries[q].first << " to " << queries[q].second << ") planned wrongly" << endl;
+		}
+	}
+	cerr << queries.size() << " queries, clusters of " << options.clusterSize << ": " << found << " routes found, " <<
+		failed << " wrong, " << (found > 0 ? 100 * excess / found : 0) << "% longer than the best on average" << endl;
+	cerr << "abstraction built in " << buildSeconds << " s, " << (hierarchy.bytes() >> 10) << " KB; flat search state " <<
+		(state.bytes() >> 10) << " KB" << endl;
+	cerr << "latency us, p50 / p99: flat A* " << flatLatency.percentile( 0.5 ) << " / " << flatLatency.percentile( 0.99 ) <<
+		", plan " << planLatency.percentile( 0.5 ) << " / " << planLatency.percentile( 0.99 ) <<
+		", refine whole route " << refineLatency.percentile( 0.5 ) << " / " << refineLatency.percentile( 0.99 ) << endl;
+	return failed;
+}
+
+// ----------------------------------------------------------------
+//  Name:           EngineCheck
+//  Description:    The queries of --engine-check and the cost and
+//                  expansions of the default search for each, which
+//                  every other configuration is held to.
+// ----------------------------------------------------------------
+struct EngineCheck {
+	vector< pair<int, int> > queries;
+	vector<QuerySummary<int> > exact;
+	int failed;
+};
+
+// ----------------------------------------------------------------
+//  Name:           timeEngine
+//  Description:    Runs queries one after another through one engine
+//                  and reports the latency, expansions and the most
+//                  memory its search state held. Every query must
+//                  end the same way as the default search and, where
+//                  there is a route, cost the same.
+//  Arguments:      The first parameter names the configuration.
+//                  The second parameter is the graph to search.
+//                  The third parameter is the engine.
+//                  The fourth parameter is the engine's state.
+//                  The fifth parameter is the check, whose failure
+//                  count goes up for each wrong answer.
+//                  The sixth parameter is how many of the queries to
+//                  run.
+//                  The seventh parameter, if given, is called with each
+//                  query's goal before it is timed.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+template<class SearchGraph, class Engine, class State>
+void timeEngine( const string& name, const SearchGraph& searchGraph, Engine& engine, State& state, EngineCheck& check,
+	size_t count, const function<void ( int )>& prepareGoal = function<void ( int )>() ) {
+	LatencyHistogram latency;
+	long long expansions = 0;
+	size_t stateBytes = 0;
+	int wrong = 0;
+	double seconds = 0;
+	for( size_t i = 0; i < count; i++ ) {
+		int start = check.queries[i].first;
+		int goal = check.queries[i].second;
+		if( prepareGoal ) {
+			prepareGoal( goal );
+		}
+		Clock::time_point queryStart = Clock::now();
+		QuerySummary<int> summary = searchGraph.boundedSearch( start, goal, QueryOptions(), state, engine );
+		double elapsed = chrono::duration<double>( Clock::now() - queryStart ).count();
+		seconds += elapsed;
+		latency.add( elapsed * 1e6 );
+		expansions += summary.expansions;
+		stateBytes = max( stateBytes, state.bytes() );
+		if( summary.status != check.exact[i].status || (summary.status == QUERY_FOUND && summary.cost != check.exact[i].cost) ) {
+			wrong++;
+		}
+	}
+	check.failed += wrong;
+	cerr << name << ": mean " << (count > 0 ? seconds * 1e6 / count : 0) << " us, p50 " << latency.percentile( 0.5 ) <<
+		", " << expansions << " expansions, state " << stateBytes / 1024 << " KB, " << wrong << " wrong" << endl;
+}
+
+// ----------------------------------------------------------------
+//  Name:           engineCheck
+//  Description:    Runs the queries with each open list, heuristic
+//                  and search state in turn, on the node graph and
+//                  the compressed one, and checks each finds routes
+//                  as cheap as the default search. The exact estimate
+//                  (every node's true cost to the goal, set with
+//                  setHeuristic from a flow field) costs a search of
+//                  the whole graph per goal to set up, so it only runs
+//                  on the first few queries.
+//  Arguments:      The first parameter is the loaded graph. Its node
+//                  heuristics are put back as they were afterwards.
+//                  The second parameter is the query input.
+//  Return Value:   The number of wrong answers.
+// ----------------------------------------------------------------
+int engineCheck( MapGraph& graph, istream& input ) {
+	EngineCheck check;
+	check.failed = 0;
+	readQueries( graph, input, check.queries );
+	graph.buildComponents();
+	SearchState<int> state;
+	for( size_t i = 0; i < check.queries.size(); i++ ) {
+		check.queries[i] = make_pair( graph.internalIndex( check.queries[i].first ), graph.internalIndex( check.queries[i].second ) );
+		check.exact.push_back( graph.boundedSearch( check.queries[i].first, check.queries[i].second, QueryOptions(), state ) );
+	}
+	size_t count = check.queries.size();
+	cerr << count << " queries on one thread" << endl;
+
+	SearchEngine<MapGraph, int> heap;
+	SearchEngine<MapGraph, int, BucketOpenList<int> > buckets;
+	SearchEngine<MapGraph, int, BinaryHeapOpenList<int>, EuclideanHeuristic<MapGraph, int>, HashSearchState<int> > heapHashed;
+	SearchEngine<MapGraph, int, BucketOpenList<int>, EuclideanHeuristic<MapGraph, int>, HashSearchState<int> > bucketsHashed;
+	SearchEngine<MapGraph, int, BinaryHeapOpenList<int>, ZeroHeuristic<int> > dijkstra;
+	SearchEngine<MapGraph, int, BinaryHeapOpenList<int>, NodeHeuristic<pair<string, int>, int> > exact;
+	HashSearchState<int> hashed;
+	vector<int> heuristics( graph.maxSize(), 0 );
+	for( int i = 0; i < graph.maxSize(); i++ ) {
+		if( graph.nodeArray()[i] != 0 ) {
+			heuristics[i] = graph.nodeArray()[i]->getHeuristic();
+		}
+	}
+	timeEngine( "heap, arrays", graph, heap, state, check, count );
+	timeEngine( "buckets, arrays", graph, buckets, state, check, count );
+	timeEngine( "heap, hash table", graph, heapHashed, hashed, check, count );
+	timeEngine( "buckets, hash table", graph, bucketsHashed, hashed, check, count );
+	timeEngine( "no estimate (Dijkstra)", graph, dijkstra, state, check, count );
+	timeEngine( "exact estimate, first 10", graph, exact, state, check, min<size_t>( count, 10 ), [&graph]( int goal ) {
+		FlowField<pair<string, int>, int> field( graph, goal );
+		for( int i = 0; i < graph.maxSize(); i++ ) {
+			if( graph.nodeArray()[i] != 0 ) {
+				// nodes that can't reach the goal are never on a route to it.
+				int distance = field.distance( i );
+				graph.nodeArray()[i]->setHeuristic( distance == numeric_limits<int>::max() ? 0 : distance );
+			}
+		}
+	} );
+	for( int i = 0; i < graph.maxSize(); i++ ) {
+		if( graph.nodeArray()[i] != 0 ) {
+			graph.nodeArray()[i]->setHeuristic( heuristics[i] );
+		}
+	}
+	cerr << "bucket ring: " << buckets.openList().buckets() << " buckets" << endl;
+
+	CompressedGraph<int> packed;
+	packed.build( graph );
+	SearchEngine<CompressedGraph<int>, int> packedHeap;
+	SearchEngine<CompressedGraph<int>, int, BucketOpenList<int> > packedBuckets;
+	timeEngine( "compressed, heap", packed, packedHeap, state, check, count );
+	timeEngine( "compressed, buckets", packed, packedBuckets, state, check, count );
+
+	cerr << (check.failed == 0 ? "every configuration matched the default search" : "some configurations gave wrong answers") << endl;
+	return check.failed;
+}
+
+// ----------------------------------------------------------------
+//  Name:           allRouteCosts
+//  Description:    Walks every loopless route from a node to the goal
+//                  and collects their costs, for checking small graphs.
+//  Arguments:      The first parameter is the graph.
+//                  The second parameter is the node reached.
+//                  The third parameter is the goal.
+//                  The fourth parameter marks the nodes on the route.
+//                  The fifth parameter is the cost so far.
+//                  The sixth parameter collects the costs.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+void allRouteCosts( MapGraph& graph, int node, int goal, vector<char>& onRoute, int cost, vector<int>& costs ) {
+	if( node == goal ) {
+		costs.push_back( cost );
+		return;
+	}
+	list<MapArc>::const_iterator iter = graph.nodeArray()[node]->arcList().begin();
+	list<MapArc>::const_iterator endIter = graph.nodeArray()[node]->arcList().end();
+	for( ; iter != endIter; ++iter ) {
+		int to = (*iter).node()->getIndex();
+		if( onRoute[to] == 0 ) {
+			onRoute[to] = 1;
+			allRouteCosts( graph, to, goal, onRoute, cost + (*iter).weight(), costs );
+			onRoute[to] = 0;
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           kShortestCheck
+//  Description:    Checks KShortestPaths against every loopless route
+//                  of small random graphs. Arcs cost at least their
+//                  length, as the estimate expects. Each route found
+//                  must be loopless, follow arcs adding up to its
+//                  cost, differ from the others and cost the same as
+//                  the route of the same rank in the full list. Both
+//                  ways of calling find must agree, and a flow field
+//                  must be refused once the graph has changed.
+//  Arguments:      The number of graphs to try.
+//  Return Value:   The number of graphs that failed.
+// ----------------------------------------------------------------
+int kShortestCheck( int trials ) {
+	// the same graphs on every machine, unlike rand.
+	mt19937 generator( 7 );
+	auto random = [&generator]( int range ) {
+		return (int)(generator() % (unsigned int)range);
+	};
+	int failed = 0;
+	for( int trial = 0; trial < trials; trial++ ) {
+		int count = 4 + random( 8 );
+		MapGraph graph( count );
+		for( int i = 0; i < count; i++ ) {
+			int x = random( 10 );
+			graph.addNode( make_pair( string( "n" ), i ), i, make_pair( x, random( 10 ) ) );
+		}
+		int arcs = count + random( 2 * count );
+		for( int i = 0; i < arcs; i++ ) {
+			int from = random( count );
+			int to = random( count );
+			if( from != to && graph.getArc( from, to ) == 0 ) {
+				double dx = graph.nodeArray()[from]->getX() - graph.nodeArray()[to]->getX();
+				double dy = graph.nodeArray()[from]->getY() - graph.nodeArray()[to]->getY();
+				graph.addArc( from, to, (int)ceil( sqrt( dx * dx + dy * dy ) ) + random( trial % 2 == 0 ? 20 : 3 ) );
+			}
+		}
+		int start = random( count );
+		int goal = random( count );
+		int k = 1 + random( 8 );
+
+		vector<int> costs;
+		vector<char> onRoute( count, 0 );
+		onRoute[start] = 1;
+		allRouteCosts( graph, start, goal, onRoute, 0, costs );
+		sort( costs.begin(), costs.end() );
+
+		KShortestPaths<pair<string, int>, int> paths( graph );
+		vector< Route<int> > routes;
+		vector< Route<int> > fieldRoutes;
+		FlowField<pair<string, int>, int> field( graph, goal );
+		int found = paths.find( start, goal, k, routes );
+		bool good = found == min( k, (int)costs.size() ) && paths.find( field, start, k, fieldRoutes ) == found;
+		set< vector<int> > distinct;
+		for( int i = 0; good == true && i < found; i++ ) {
+			const vector<int>& path = routes[i].path;
+			vector<char> visited( count, 0 );
+			int cost = 0;
+			good = routes[i].cost == costs[i] && fieldRoutes[i].cost == costs[i] &&
+				path.front() == start && path.back() == goal && distinct.insert( path ).second == true;
+			for( size_t j = 0; good == true && j < path.size(); j++ ) {
+				good = visited[path[j]]++ == 0;
+				if( good == true && j > 0 ) {
+					MapArc* pArc = graph.getArc( path[j - 1], path[j] );
+					good = pArc != 0;
+					cost += pArc != 0 ? pArc->weight() : 0;
+				}
+			}
+			good = good == true && cost == routes[i].cost;
+		}
+
+		// any change to the graph makes the field stale.
+		graph.removeNode( count - 1 );
+		good = good == true && paths.find( field, start, k, fieldRoutes ) == -1;
+		if( good == false ) {
+			cerr << "k shortest paths: graph " << trial << " failed" << endl;
+			failed++;
+		}
+	}
+	cerr << "k shortest paths: " << trials - failed << " of " << trials << " random graphs passed" << endl;
+	return failed;
+}
+
+void usage() {
+	cerr << "usage: SearchChecks [options] CHECK [queries-file]\n"
+		"  reads \"start goal\" pairs from queries-file, or standard input if none or \"-\"\n"
+		"  CHECK is one of:\n"
+		"  --reorder-bench      time the queries in each node ordering\n"
+		"  --numa-bench         time each memory node with and without its own copy\n"
+		"                       of the compressed graph\n"
+		"  --hierarchical N     plan with clusters N units wide, check the routes and\n"
+		"                       compare them with the flat search\n"
+		"  --engine-check       time each open list, estimate and search state and\n"
+		"                       check their routes against the default search\n"
+		"  --k-shortest-check N check the k shortest routes on N random graphs\n"
+		"  options:\n"
+		"  --nodes FILE         node file (default Nodes.txt)\n"
+		"  --arcs FILE          arc file (default Arcs.txt)\n"
+		"  --file-weights       use the arc file's weights instead of arc lengths\n"
+		"  --binary FILE        load a binary graph instead of the text files\n"
+		"  --compressed         time the compressed copy of the arcs (--reorder-bench)\n"
+		"  --huge-pages         keep the copies in huge pages (--numa-bench)\n"
+		"  --threads N          worker threads (default: one per core)\n"
+		"  --window N           most queries in flight at once (default 256)\n"
+		"  --max-expansions N   node expansion limit per query\n";
+}
+
+// ----------------------------------------------------------------
+//  Name:           parseArguments
+//  Description:    Reads the command line into the settings.
+//  Arguments:      The first and second parameters are main's.
+//                  The third parameter is filled in.
+//  Return Value:   false if the command line is wrong or doesn't
+//                  name exactly one check.
+// ----------------------------------------------------------------
+bool parseArguments( int argc, char* argv[], Options& options ) {
+	for( int i = 1; i < argc; i++ ) {
+		string flag = argv[i];
+		bool hasValue = i + 1 < argc;
+		if( flag == "--file-weights" ) {
+			options.fileWeights = true;
+		}
+		else if( flag == "--compressed" ) {
+			options.compressed = true;
+		}
+		else if( flag == "--huge-pages" ) {
+			options.hugePages = true;
+		}
+		else if( flag == "--numa-bench" ) {
+			options.numaBench = true;
+		}
+		else if( flag == "--reorder-bench" ) {
+			options.reorderBench = true;
+		}
+		else if( flag == "--engine-check" ) {
+			options.engineCheck = true;
+		}
+		else if( flag.compare( 0, 2, "--" ) != 0 ) {
+			options.queriesFile = flag;
+		}
+		else if( hasValue == false ) {
+			return false;
+		}
+		else {
+			string value = argv[++i];
+			if( flag == "--nodes" ) {
+				options.nodesFile = value;
+			}
+			else if( flag == "--arcs" ) {
+				options.arcsFile = value;
+			}
+			else if( flag == "--binary" ) {
+				options.binaryFile = value;
+			}
+			else if( flag == "--threads" ) {
+				options.threads = atoi( value.c_str() );
+			}
+			else if( flag == "--window" ) {
+				options.window = atoi( value.c_str() );
+			}
+			else if( flag == "--hierarchical" ) {
+				options.clusterSize = atoi( value.c_str() );
+				if( options.clusterSize <= 0 ) {
+					return false;
+				}
+			}
+			else if( flag == "--k-shortest-check" ) {
+				options.kShortestTrials = atoi( value.c_str() );
+				if( options.kShortestTrials <= 0 ) {
+					return false;
+				}
+			}
+			else if( flag == "--max-expansions" ) {
+				options.maxExpansions = atoi( value.c_str() );
+			}
+			else {
+				return false;
+			}
+		}
+	}
+	int checks = (options.reorderBench == true) + (options.numaBench == true) + (options.engineCheck == true) +
+		(options.clusterSize > 0) + (options.kShortestTrials > 0);
+	return checks == 1;
+}
+
+int main( int argc, char* argv[] ) {
+	ios::sync_with_stdio( false );
+
+	Options options;
+	if( parseArguments( argc, argv, options ) == false ) {
+		usage();
+		return 2;
+	}
+	if( options.kShortestTrials > 0 ) {
+		return kShortestCheck( options.kShortestTrials ) > 0 ? 1 : 0;
+	}
+
+	ifstream file;
+	if( options.queriesFile.empty() == false && options.queriesFile != "-" ) {
+		file.open( options.queriesFile.c_str() );
+		if( !file ) {
+			cerr << "could not read " << options.queriesFile << endl;
+			return 1;
+		}
+	}
+	istream& input = file.is_open() ? file : cin;
+
+	Clock::time_point loadStart = Clock::now();
+	MapGraph* pGraph;
+	if( options.binaryFile.empty() == false ) {
+		pGraph = loadBinaryGraph<int>( options.binaryFile );
+	}
+	else {
+		pGraph = loadTextGraph<int>( options.nodesFile, options.arcsFile, options.fileWeights );
+	}
+	if( pGraph == 0 ) {
+		cerr << "could not load the graph" << endl;
+		return 1;
+	}
+	cerr << "loaded " << pGraph->size() << " nodes in " <<
+		chrono::duration<double>( Clock::now() - loadStart ).count() << " s" << endl;
+
+	int failed = 0;
+	if( options.reorderBench == true ) {
+		reorderBench( *pGraph, input, options );
+	}
+	else if( options.numaBench == true ) {
+		pGraph->buildComponents();
+		CompressedGraph<int> packed;
+		packed.build( *pGraph );
+		NumaReplicas<int> replicas( packed, options.hugePages );
+		numaBench( packed, replicas, *pGraph, input, options );
+	}
+	else if( options.clusterSize > 0 ) {
+		failed = hierarchicalCheck( *pGraph, input, options );
+	}
+	else {
+		failed = engineCheck( *pGraph, input );
+	}
+	delete pGraph;
+	return failed > 0 ? 1 : 0;
+}
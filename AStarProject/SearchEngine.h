@@ -0,0 +1,589 @@
+#ifndef SEARCHENGINE_H
+#define SEARCHENGINE_H
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <functional>
+
+#include "SearchQuery.h"
+
+template<class NodeType, class ArcType> class Graph;
+template<class NodeType, class ArcType> class GraphNode;
+
+// ----------------------------------------------------------------
+//  Description:    Policies for SearchEngine. Each is a small class
+//                  with inline members, so the engine's loop is
+//                  compiled separately for every combination and
+//                  anything a configuration doesn't use leaves no
+//                  code behind.
+//
+//                  Graphs are searched by node index, like Graph and
+//                  CompressedGraph:
+//                      int maxSize() const;
+//                      ArcCursor arcs( int node ) const;
+//                      ArcType estimate( int from, int to ) const;
+//                  where the cursor walks one node's arcs, with next()
+//                  called before reading the first:
+//                      bool next();
+//                      int node() const;
+//                      ArcType weight() const;
+//
+//                  Open lists hold (priority, node) pairs and hand
+//                  back the lowest priority first:
+//                      void clear();
+//                      void push( ArcType priority, int node );
+//                      int pop();
+//                      bool empty() const;
+//
+//                  Heuristics estimate the cost left to the goal:
+//                      void begin( const SearchGraph& graph, int goal );
+//                      ArcType estimate( int node ) const;
+//
+//                  States hold each node's cost, previous node and
+//                  whether it is closed, like SearchState.
+//
+//                  Observers are told as the search goes:
+//                      void reached( int node, ArcType cost, ArcType estimate );
+//                      void expanded( int node );
+// ----------------------------------------------------------------
+
+// ----------------------------------------------------------------
+//  Name:           BinaryHeapOpenList
+//  Description:    Binary heap open list. Nodes whose cost improves
+//                  are pushed again and the stale entries skipped when
+//                  popped. It can borrow the storage of a SearchState
+//                  so a search needs no allocation of its own.
+// ----------------------------------------------------------------
+template<class ArcType>
+class BinaryHeapOpenList {
+private:
+	typedef pair<ArcType, int> Entry;
+
+	vector<Entry> m_entries;
+	vector<Entry>* m_pEntries;
+
+public:
+	BinaryHeapOpenList() : m_pEntries( &m_entries ) {
+	}
+
+	BinaryHeapOpenList( const BinaryHeapOpenList& other ) : m_entries( other.m_entries ),
+		m_pEntries( other.m_pEntries == &other.m_entries ? &m_entries : other.m_pEntries ) {
+	}
+
+	BinaryHeapOpenList& operator=( const BinaryHeapOpenList& other ) {
+		m_entries = other.m_entries;
+		m_pEntries = other.m_pEntries == &other.m_entries ? &m_entries : other.m_pEntries;
+		return *this;
+	}
+
+	// keeps the entries in a caller's vector from now on.
+	void useStorage( vector<Entry>& entries ) {
+		m_pEntries = &entries;
+	}
+
+	void clear() {
+		m_pEntries->clear();
+	}
+
+	void push( ArcType priority, int node ) {
+		m_pEntries->push_back( Entry( priority, node ) );
+		push_heap( m_pEntries->begin(), m_pEntries->end(), greater<Entry>() );
+	}
+
+	int pop() {
+		pop_heap( m_pEntries->begin(), m_pEntries->end(), greater<Entry>() );
+		int node = m_pEntries->back().second;
+		m_pEntries->pop_back();
+		return node;
+	}
+
+	bool empty() const {
+		return m_pEntries->empty();
+	}
+};
+
+// ----------------------------------------------------------------
+//  Name:           BucketOpenList
+//  Description:    Open list of one bucket per whole-number priority,
+//                  so a push or pop costs O(1) in place of a heap's
+//                  O(log n). It suits integer weights with a consistent
+//                  estimate, where the priorities popped never fall and
+//                  those waiting span little more than twice the
+//                  heaviest arc (an arc's end can be at most its weight
+//                  further from the goal by the estimate). The buckets
+//                  are a ring covering just that span: priority p goes
+//                  in bucket p modulo the ring's size, and the ring
+//                  doubles if ever the span outgrows it. The buckets
+//                  are kept between searches, so once the ring has
+//                  grown a search allocates nothing.
+// ----------------------------------------------------------------
+template<class ArcType>
+class BucketOpenList {
+private:
+	static_assert( numeric_limits<ArcType>::is_integer, "BucketOpenList needs whole-number weights" );
+
+	// every entry's priority lies from m_low to m_high, which are
+	// less than the ring's size apart.
+	vector< vector<int> > m_buckets;
+	size_t m_mask;
+	ArcType m_low;
+	ArcType m_high;
+	size_t m_count;
+
+	vector<int>& bucket( ArcType priority ) {
+		return m_buckets[(size_t)priority & m_mask];
+	}
+
+	// ----------------------------------------------------------------
+	//  Name:           grow
+	//  Description:    Doubles the ring until it covers a span of
+	//                  priorities, moving the waiting entries across.
+	//  Arguments:      The lowest and highest priorities to cover.
+	//  Return Value:   None.
+	// ----------------------------------------------------------------
+	void grow( ArcType low, ArcType high ) {
+		size_t size = m_buckets.size() > 0 ? m_buckets.size() * 2 : 64;
+		while( size <= (size_t)(high - low) ) {
+			size *= 2;
+		}
+		vector< vector<int> > buckets( size );
+		for( ArcType priority = m_low; m_count > 0 && priority <= m_high; priority++ ) {
+			buckets[(size_t)priority & (size - 1)].swap( bucket( priority ) );
+		}
+		m_buckets.swap( buckets );
+		m_mask = size - 1;
+	}
+
+public:
+	BucketOpenList() : m_mask( 0 ), m_low( 0 ), m_high( 0 ), m_count( 0 ) {
+	}
+
+	void clear() {
+		for( ArcType priority = m_low; m_count > 0 && priority <= m_high; priority++ ) {
+			bucket( priority ).clear();
+		}
+		m_count = 0;
+	}
+
+	void push( ArcType priority, int node ) {
+		if( m_count == 0 ) {
+			m_low = priority;
+			m_high = priority;
+		}
+		// an estimate that isn't consistent can go back below the lowest.
+		ArcType low = priority < m_low ? priority : m_low;
+		ArcType high = priority > m_high ? priority : m_high;
+		if( m_buckets.size() == 0 || (size_t)(high - low) > m_mask ) {
+			grow( low, high );
+		}
+		m_low = low;
+		m_high = high;
+		bucket( priority ).push_back( node );
+		m_count++;
+	}
+
+	int pop() {
+		while( bucket( m_low ).empty() == true ) {
+			m_low++;
+		}
+		vector<int>& lowest = bucket( m_low );
+		int node = lowest.back();
+		lowest.pop_back();
+		m_count--;
+		return node;
+	}
+
+	bool empty() const {
+		return m_count == 0;
+	}
+
+	// the ring's size, which bounds its memory.
+	size_t buckets() const {
+		return m_buckets.size();
+	}
+};
+
+// ----------------------------------------------------------------
+//  Name:           EuclideanHeuristic
+//  Description:    The graph's own estimate, the straight line
+//                  distance to the goal cut to 90%.
+// ----------------------------------------------------------------
+template<class SearchGraph, class ArcType>
+class EuclideanHeuristic {
+private:
+	const SearchGraph* m_pGraph;
+	int m_goal;
+
+public:
+	EuclideanHeuristic() : m_pGraph( 0 ), m_goal( -1 ) {
+	}
+
+	void begin( const SearchGraph& graph, int goal ) {
+		m_pGraph = &graph;
+		m_goal = goal;
+	}
+
+	ArcType estimate( int node ) const {
+		return m_pGraph->estimate( node, m_goal );
+	}
+};
+
+// ----------------------------------------------------------------
+//  Name:           NodeHeuristic
+//  Description:    The estimate stored in each node by setHeuristic,
+//                  for instance one loaded with SearchArtifacts. The
+//                  values must have been worked out for this goal.
+//                  Only a Graph has them.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+class NodeHeuristic {
+private:
+	GraphNode<NodeType, ArcType>** m_pNodes;
+
+public:
+	NodeHeuristic() : m_pNodes( 0 ) {
+	}
+
+	void begin( const Graph<NodeType, ArcType>& graph, int ) {
+		m_pNodes = graph.nodeArray();
+	}
+
+	ArcType estimate( int node ) const {
+		return (ArcType)m_pNodes[node]->getHeuristic();
+	}
+};
+
+// ----------------------------------------------------------------
+//  Name:           ZeroHeuristic
+//  Description:    No estimate, which makes the search Dijkstra's.
+// ----------------------------------------------------------------
+template<class ArcType>
+class ZeroHeuristic {
+public:
+	template<class SearchGraph>
+	void begin( const SearchGraph&, int ) {
+	}
+
+	ArcType estimate( int ) const {
+		return 0;
+	}
+};
+
+// ----------------------------------------------------------------
+//  Name:           HashSearchState
+//  Description:    Search state kept in a hash table of the nodes
+//                  touched, in place of SearchState's arrays the size
+//                  of the graph. Slower per node, but its memory
+//                  follows the size of the search, which suits short
+//                  searches on very large graphs.
+// ----------------------------------------------------------------
+template<class ArcType>
+class HashSearchState {
+private:
+	struct Record {
+		ArcType cost;
+		int previous;
+		bool seen;
+		bool closed;
+
+		Record() : cost( numeric_limits<ArcType>::max() ), previous( -1 ), seen( false ), closed( false ) {
+		}
+	};
+
+	unordered_map<int, Record> m_records;
+
+	const Record* find( int node ) const {
+		typename unordered_map<int, Record>::const_iterator iter = m_records.find( node );
+		return iter == m_records.end() ? 0 : &iter->second;
+	}
+
+public:
+	void begin( int ) {
+		m_records.clear();
+	}
+
+	bool seen( int node ) const {
+		const Record* pRecord = find( node );
+		return pRecord != 0 && pRecord->seen == true;
+	}
+
+	bool closed( int node ) const {
+		const Record* pRecord = find( node );
+		return pRecord != 0 && pRecord->closed == true;
+	}
+
+	ArcType cost( int node ) const {
+		const Record* pRecord = find( node );
+		return pRecord != 0 && pRecord->seen == true ? pRecord->cost : numeric_limits<ArcType>::max();
+	}
+
+	int previous( int node ) const {
+		const Record* pRecord = find( node );
+		return pRecord != 0 ? pRecord->previous : -1;
+	}
+
+	void reach( int node, ArcType cost, int previous ) {
+		Record& record = m_records[node];
+		record.seen = true;
+		record.cost = cost;
+		record.previous = previous;
+	}
+
+	void close( int node ) {
+		m_records[node].closed = true;
+	}
+
+	// about the memory held: a list node per record and the table.
+	size_t bytes() const {
+		return m_records.size() * (sizeof( pair<const int, Record> ) + 2 * sizeof( void* )) + m_records.bucket_count() * sizeof( void* );
+	}
+
+	// the path that ends at a node, start first.
+	void writePath( int end, vector<int>& path ) const {
+		path.clear();
+		for( int node = end; node != -1; node = previous( node ) ) {
+			path.push_back( node );
+		}
+		reverse( path.begin(), path.end() );
+	}
+};
+
+// ----------------------------------------------------------------
+//  Name:           NullObserver
+//  Description:    Watches nothing. Its empty members vanish when
+//                  inlined, so a search with it does no extra work.
+// ----------------------------------------------------------------
+class NullObserver {
+public:
+	template<class ArcType>
+	void reached( int, ArcType, ArcType ) {
+	}
+
+	void expanded( int ) {
+	}
+};
+
+// ----------------------------------------------------------------
+//  Name:           ViewerObserver
+//  Description:    Shows a search in the viewer: nodes reached are
+//                  coloured as searched and keep their cost (in the
+//                  second member of the node data, as the viewer's
+//                  graph does) and estimate for the node info panel,
+//                  and showPath colours the route found.
+// ----------------------------------------------------------------
+template<class NodeType, class ArcType>
+class ViewerObserver {
+private:
+	GraphNode<NodeType, ArcType>** m_pNodes;
+
+public:
+	ViewerObserver( const Graph<NodeType, ArcType>& graph ) : m_pNodes( graph.nodeArray() ) {
+	}
+
+	void reached( int node, ArcType cost, ArcType estimate ) {
+		m_pNodes[node]->setColor( 2 );
+		m_pNodes[node]->data().second = cost;
+		m_pNodes[node]->setHeuristic( estimate );
+	}
+
+	void expanded( int ) {
+	}
+
+	// colours a route, leaving highlighted nodes as they are.
+	void showPath( const vector<int>& path ) {
+		for( size_t i = 0; i < path.size(); i++ ) {
+			if( m_pNodes[path[i]]->getColor() != 3 ) {
+				m_pNodes[path[i]]->setColor( 1 );
+			}
+		}
+	}
+};
+
+// ----------------------------------------------------------------
+//  Name:           NoLimits
+//  Description:    Stands in for QueryOptions when a search runs to
+//                  the end, so the limit checks compile away.
+// ----------------------------------------------------------------
+struct NoLimits {
+};
+
+// ----------------------------------------------------------------
+//  Name:           SearchEngine
+//  Description:    A* put together from policies: the graph searched
+//                  (a Graph, a CompressedGraph or anything else that
+//                  reads like them), the weight type (ArcType), the
+//                  open list, the heuristic, the search state (which
+//                  holds the closed set) and an observer. Search with
+//                  limits through QueryOptions, or without any. An
+//                  engine can be kept and reused, as can its state.
+// ----------------------------------------------------------------
+template<class SearchGraph, class ArcType,
+	class OpenList = BinaryHeapOpenList<ArcType>,
+	class Heuristic = EuclideanHeuristic<SearchGraph, ArcType>,
+	class State = SearchState<ArcType>,
+	class Observer = NullObserver>
+class SearchEngine {
+private:
+	OpenList m_open;
+	Heuristic m_heuristic;
+	Observer m_observer;
+
+	// whether to stop now, and whether to track the node nearest the
+	// goal for a search that is cut short.
+	static bool stop( const NoLimits&, QuerySummary<ArcType>& ) {
+		return false;
+	}
+
+	static bool partial( const NoLimits& ) {
+		return false;
+	}
+
+	static bool stop( const QueryOptions& options, QuerySummary<ArcType>& result );
+
+	static bool partial( const QueryOptions& ) {
+		return true;
+	}
+
+	template<class Limits>
+	QuerySummary<ArcType> search( const SearchGraph& graph, int start, int goal, const Limits& limits, State& state );
+
+public:
+	SearchEngine() {
+	}
+
+	SearchEngine( const Heuristic& heuristic, const Observer& observer ) : m_heuristic( heuristic ), m_observer( observer ) {
+	}
+
+	OpenList& openList() {
+		return m_open;
+	}
+
+	Heuristic& heuristic() {
+		return m_heuristic;
+	}
+
+	Observer& observer() {
+		return m_observer;
+	}
+
+	// ----------------------------------------------------------------
+	//  Name:           run
+	//  Description:    Searches from start to goal to the end.
+	//  Arguments:      The first parameter is the graph.
+	//                  The second and third parameters are the start
+	//                  and goal node indices.
+	//                  The fourth parameter is the state to search in,
+	//                  which holds the path afterwards.
+	//  Return Value:   How the search ended.
+	// ----------------------------------------------------------------
+	QuerySummary<ArcType> run( const SearchGraph& graph, int start, int goal, State& state ) {
+		return search( graph, start, goal, NoLimits(), state );
+	}
+
+	// ----------------------------------------------------------------
+	//  Name:           run
+	//  Description:    Searches from start to goal within limits, like
+	//                  Graph::boundedSearch.
+	//  Arguments:      As above, with the limits before the state.
+	//  Return Value:   How the search ended.
+	// ----------------------------------------------------------------
+	QuerySummary<ArcType> run( const SearchGraph& graph, int start, int goal, const QueryOptions& options, State& state ) {
+		return search( graph, start, goal, options, state );
+	}
+};
+
+template<class SearchGraph, class ArcType, class OpenList, class Heuristic, class State, class Observer>
+bool SearchEngine<SearchGraph, ArcType, OpenList, Heuristic, State, Observer>::stop( const QueryOptions& options, QuerySummary<ArcType>& result ) {
+	if( options.maxExpansions > 0 && result.expansions >= options.maxExpansions ) {
+		result.status = QUERY_OVER_BUDGET;
+		return true;
+	}
+	if( options.checkInterval <= 1 || result.expansions % options.checkInterval == 0 ) {
+		if( options.pToken != 0 && options.pToken->cancelled() == true ) {
+			result.status = QUERY_CANCELLED;
+			return true;
+		}
+		if( options.hasDeadline == true && QueryOptions::Clock::now() >= options.deadline ) {
+			result.status = QUERY_TIMED_OUT;
+			return true;
+		}
+	}
+	return false;
+}
+
+// ----------------------------------------------------------------
+//  Name:           search
+//  Description:    The A* loop. If the limits cut it short, the
+//                  summary ends at the node closest to the goal by the
+//                  heuristic.
+//  Arguments:      The first parameter is the graph.
+//                  The second and third parameters are the start and
+//                  goal node indices.
+//                  The fourth parameter is the limits.
+//                  The fifth parameter is the state to search in.
+//  Return Value:   How the search ended.
+// ----------------------------------------------------------------
+template<class SearchGraph, class ArcType, class OpenList, class Heuristic, class State, class Observer>
+template<class Limits>
+QuerySummary<ArcType> SearchEngine<SearchGraph, ArcType, OpenList, Heuristic, State, Observer>::search( const SearchGraph& graph, int start, int goal, const Limits& limits, State& state ) {
+	QuerySummary<ArcType> result;
+
+	m_heuristic.begin( graph, goal );
+	m_open.clear();
+	state.begin( graph.maxSize() );
+	state.reach( start, 0, -1 );
+	int best = start;
+	ArcType bestEstimate = m_heuristic.estimate( start );
+	m_open.push( bestEstimate, start );
+
+	while( m_open.empty() == false ) {
+		if( stop( limits, result ) == true ) {
+			break;
+		}
+
+		int node = m_open.pop();
+		if( state.closed( node ) == true ) {
+			continue;
+		}
+		state.close( node );
+		if( node == goal ) {
+			result.status = QUERY_FOUND;
+			break;
+		}
+		result.expansions++;
+		m_observer.expanded( node );
+
+		ArcType cost = state.cost( node );
+		if( partial( limits ) == true ) {
+			ArcType remaining = m_heuristic.estimate( node );
+			if( remaining < bestEstimate ) {
+				best = node;
+				bestEstimate = remaining;
+			}
+		}
+
+		typename SearchGraph::ArcCursor cursor = graph.arcs( node );
+		while( cursor.next() == true ) {
+			int to = cursor.node();
+			ArcType distance = cost + cursor.weight();
+			if( state.closed( to ) == false && distance < state.cost( to ) ) {
+				ArcType remaining = m_heuristic.estimate( to );
+				state.reach( to, distance, node );
+				m_observer.reached( to, distance, remaining );
+				m_open.push( distance + remaining, to );
+			}
+		}
+	}
+
+	if( result.status != QUERY_NO_PATH ) {
+		// the goal, or the closest node if cut short.
+		result.end = result.status == QUERY_FOUND ? goal : best;
+		result.cost = state.cost( result.end );
+	}
+	return result;
+}
+
+#endif
@@ -0,0 +1,243 @@
+#ifndef SEARCHQUERY_H
+#define SEARCHQUERY_H
+
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <utility>
+
+using namespace std;
+
+// ----------------------------------------------------------------
+//  Name:           QueryStatus
+//  Description:    How a bounded search ended.
+// ----------------------------------------------------------------
+enum QueryStatus {
+	QUERY_FOUND,			// the goal was reached
+	QUERY_NO_PATH,			// the goal can't be reached
+	QUERY_TIMED_OUT,		// the deadline passed
+	QUERY_OVER_BUDGET,		// too many nodes were expanded
+	QUERY_CANCELLED			// the cancellation token was set
+};
+
+// ----------------------------------------------------------------
+//  Name:           CancellationToken
+//  Description:    Shared flag a caller sets to stop a search that is
+//                  running on another thread. The search checks it
+//                  between expansions.
+// ----------------------------------------------------------------
+class CancellationToken {
+private:
+	atomic<bool> m_cancelled;
+
+public:
+	CancellationToken() : m_cancelled( false ) {
+	}
+
+	void cancel() {
+		m_cancelled.store( true );
+	}
+
+	void reset() {
+		m_cancelled.store( false );
+	}
+
+	bool cancelled() const {
+		return m_cancelled.load( memory_order_relaxed );
+	}
+};
+
+// ----------------------------------------------------------------
+//  Name:           QueryOptions
+//  Description:    Limits on a single search. The defaults are no
+//                  limits at all.
+// ----------------------------------------------------------------
+struct QueryOptions {
+	typedef chrono::steady_clock Clock;
+
+	// wall-clock time the search must finish by, if hasDeadline.
+	bool hasDeadline;
+	Clock::time_point deadline;
+
+	// most nodes the search may expand, or 0 for no limit.
+	int maxExpansions;
+
+	// checked between expansions if not null.
+	const CancellationToken* pToken;
+
+	// expansions between deadline and token checks.
+	int checkInterval;
+
+	QueryOptions() : hasDeadline( false ), maxExpansions( 0 ), pToken( 0 ), checkInterval( 64 ) {
+	}
+
+	// sets the deadline to a time from now.
+	void setTimeout( Clock::duration timeout ) {
+		hasDeadline = true;
+		deadline = Clock::now() + timeout;
+	}
+};
+
+// ----------------------------------------------------------------
+//  Name:           QueryResult
+//  Description:    Outcome of a bounded search. When the search is
+//                  stopped early, the path leads to the expanded node
+//                  that looked closest to the goal, and cost is the
+//                  cost of that partial path.
+// ----------------------------------------------------------------
+template<class ArcType>
+struct QueryResult {
+	QueryStatus status;
+	ArcType cost;
+	vector<int> path;
+	int expansions;
+
+	QueryResult() : status( QUERY_NO_PATH ), cost( 0 ), expansions( 0 ) {
+	}
+};
+
+// ----------------------------------------------------------------
+//  Name:           QuerySummary
+//  Description:    Outcome of a bounded search without the path. The
+//                  path stays in the search state, and can be copied
+//                  out with SearchState::writePath until the state is
+//                  used again. end is the last node of that path: the
+//                  goal, or the closest node if the search stopped
+//                  early, or -1 if there is no path.
+// ----------------------------------------------------------------
+template<class ArcType>
+struct QuerySummary {
+	QueryStatus status;
+	ArcType cost;
+	int expansions;
+	int end;
+
+	QuerySummary() : status( QUERY_NO_PATH ), cost( 0 ), expansions( 0 ), end( -1 ) {
+	}
+};
+
+// ----------------------------------------------------------------
+//  Name:           SearchState
+//  Description:    Scratch arrays for one search at a time. Each
+//                  entry is stamped with the search that wrote it, so
+//                  a search only touches the nodes it reaches instead
+//                  of clearing arrays the size of the graph. Keep one
+//                  per thread and reuse it.
+// ----------------------------------------------------------------
+template<class ArcType>
+class SearchState {
+private:
+	vector<ArcType> m_cost;
+	vector<int> m_previous;
+	vector<unsigned int> m_seen;
+	vector<unsigned int> m_closed;
+	unsigned int m_generation;
+
+public:
+	// open list storage, as (estimated total cost, node) pairs.
+	vector< pair<ArcType, int> > open;
+
+	SearchState() : m_generation( 0 ) {
+	}
+
+	// ----------------------------------------------------------------
+	//  Name:           begin
+	//  Description:    Starts a new search over a graph of a given size.
+	//  Arguments:      The maximum number of nodes in the graph.
+	//  Return Value:   None.
+	// ----------------------------------------------------------------
+	void begin( int size ) {
+		if( (int)m_cost.size() < size ) {
+			m_cost.resize( size );
+			m_previous.resize( size );
+			m_seen.resize( size, 0 );
+			m_closed.resize( size, 0 );
+		}
+		m_generation++;
+		if( m_generation == 0 ) {
+			// the stamps wrapped round, so old ones could match again.
+			fill( m_seen.begin(), m_seen.end(), 0 );
+			fill( m_closed.begin(), m_closed.end(), 0 );
+			m_generation = 1;
+		}
+		open.clear();
+	}
+
+	bool seen( int node ) const {
+		return m_seen[node] == m_generation;
+	}
+
+	bool closed( int node ) const {
+		return m_closed[node] == m_generation;
+	}
+
+	ArcType cost( int node ) const {
+		return seen( node ) ? m_cost[node] : numeric_limits<ArcType>::max();
+	}
+
+	int previous( int node ) const {
+		return m_previous[node];
+	}
+
+	void reach( int node, ArcType cost, int previous ) {
+		m_seen[node] = m_generation;
+		m_cost[node] = cost;
+		m_previous[node] = previous;
+	}
+
+	void close( int node ) {
+		m_closed[node] = m_generation;
+	}
+
+	// the memory held, in bytes.
+	size_t bytes() const {
+		return m_cost.capacity() * sizeof( ArcType ) + (m_previous.capacity() + m_seen.capacity() + m_closed.capacity()) * sizeof( int ) +
+			open.capacity() * sizeof( pair<ArcType, int> );
+	}
+
+	// ----------------------------------------------------------------
+	//  Name:           writePath
+	//  Description:    Copies the path that ends at a node into a
+	//                  caller's buffer, start first. Nothing is written
+	//                  unless the whole path fits, so a caller can ask
+	//                  for the length with an empty buffer and retry.
+	//  Arguments:      The first parameter is the last node of the path.
+	//                  The second parameter is the buffer.
+	//                  The third parameter is the buffer's size.
+	//  Return Value:   The number of nodes on the path.
+	// ----------------------------------------------------------------
+	int writePath( int end, int* pNodes, int capacity ) const {
+		int length = 0;
+		for( int node = end; node != -1; node = m_previous[node] ) {
+			length++;
+		}
+		if( length <= capacity ) {
+			int slot = length;
+			for( int node = end; node != -1; node = m_previous[node] ) {
+				pNodes[--slot] = node;
+			}
+		}
+		return length;
+	}
+
+	// ----------------------------------------------------------------
+	//  Name:           writePath
+	//  Description:    Copies the path that ends at a node into a
+	//                  vector, start first, reusing its memory.
+	//  Arguments:      The first parameter is the last node of the path,
+	//                  or -1 for an empty path.
+	//                  The second parameter is filled with the path.
+	//  Return Value:   None.
+	// ----------------------------------------------------------------
+	void writePath( int end, vector<int>& path ) const {
+		path.clear();
+		if( end != -1 ) {
+			path.resize( writePath( end, 0, 0 ) );
+			writePath( end, &path[0], (int)path.size() );
+		}
+	}
+};
+
+#endif
@@ -22,15 +22,62 @@
 #include <string>
 #include <utility>
 #include <map>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 
 #include "Graph.h"
+#include "GraphIO.h"
+#include "GraphView.h"
 
 
 using namespace std;
 
-typedef GraphArc<pair<string, int>, int> Arc1;
 typedef GraphNode<pair<string, int>, int> Node;
 
+// ----------------------------------------------------------------
+//  Name:           benchmark
+//  Description:    Renders the graph offscreen a number of times and
+//                  prints the frame times, so drawing speed can be
+//                  measured without a screen (e.g. under Xvfb).
+//  Arguments:      The first parameter is the built view.
+//                  The second parameter is the graph.
+//                  The third parameter is the number of frames.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+void benchmark(GraphView<pair<string, int>, int>& view, Graph<pair<string, int>, int>& graph, int frames) {
+	sf::RenderTexture target;
+	if (!target.create(1280, 720)) {
+		cout << "Could not create an offscreen render target" << endl;
+		return;
+	}
+
+	std::vector<double> times;
+	times.reserve(frames);
+	for (int frame = 0; frame < frames; frame++) {
+		//change one node a frame, as hovering the mouse would
+		int node = frame % graph.size();
+		graph.nodeArray()[node]->setColor(graph.nodeArray()[node]->getColor() == 0 ? 3 : 0);
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		target.clear();
+		view.update(graph);
+		view.draw(target);
+		target.display();
+		//wait for the GPU so the time covers the whole frame
+		glFinish();
+		times.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+	}
+
+	std::sort(times.begin(), times.end());
+	double total = 0;
+	for (int i = 0; i < frames; i++)
+		total += times[i];
+	cout << graph.size() << " nodes, " << frames << " frames: mean " << total / frames << " ms, p50 " << times[frames / 2] <<
+		" ms, p99 " << times[frames * 99 / 100] << " ms, max " << times[frames - 1] << " ms" << endl;
+}
+
 int main(int argc, char *argv[]) {
 
 	sf::Texture resetButtonTexture;
@@ -61,152 +108,88 @@ int main(int argc, char *argv[]) {
 	info.setTexture(infoTexture);
 	info.setPosition(970, 290);
 
-	sf::RenderWindow window(sf::VideoMode(1280, 720, 32), "A* PathFinding");
-	window.setFramerateLimit(60);	
-
-	int const graphSize = 30;
-	Graph<pair<string, int>, int> graph(graphSize);
-
-	string stringArray[graphSize];
-	std::pair<int, int> nodePositions[graphSize];
-
-	string tempString;
-	std::vector<Node*> path;
-	path.reserve(20);
-
-	pair<string, int> temp;
-	temp.second = INT_MAX; //setting the value on the node to 'infinite'
-
-	ifstream myfile;
-	myfile.open("Nodes.txt");
-	
-	int index = 0;
-
-	int x, y;
-	while (myfile >> tempString >> x >> y) {
-		//getline(myfile, tempString);
-		stringArray[index] = tempString;
-		nodePositions[index] = make_pair(x * 2 / 1.1, y * 2 / 1.1);
-		index++;
+	//the graph files can be given on the command line, and "--bench frames"
+	//first renders that many frames offscreen and reports the frame times
+	int benchFrames = 0;
+	int argument = 1;
+	if (argc > 2 && string(argv[1]) == "--bench") {
+		benchFrames = atoi(argv[2]);
+		argument = 3;
 	}
+	string nodesFile = argc > argument ? argv[argument] : "Nodes.txt";
+	string arcsFile = argc > argument + 1 ? argv[argument + 1] : "Arcs.txt";
 
-	index = 0;
-	//add nodes with values from 0 -> 6
-	while(index < graphSize) {
-		temp.first = stringArray[index];
-		graph.addNode(temp, index, nodePositions[index]);
-		index++;
+	Graph<pair<string, int>, int>* pGraph = loadTextGraph<int>(nodesFile, arcsFile);
+	if (pGraph == 0) {
+		cout << "Could not load " << nodesFile << " and " << arcsFile << endl;
+		return 1;
 	}
-	myfile.close();
+	Graph<pair<string, int>, int>& graph = *pGraph;
 
-	myfile.open("Arcs.txt");
+	std::vector<Node*> path;
+	path.reserve(graph.size());
+
+	//index the connected parts of the graph so impossible searches are rejected straight away
+	graph.buildComponents();
 
-	int from, to, weight;
-	while (myfile >> from >> to >> weight) {
-		sf::Vector2f start = sf::Vector2f(graph.nodeArray()[from]->getX(), graph.nodeArray()[from]->getY());
-		sf::Vector2f end = sf::Vector2f(graph.nodeArray()[to]->getX(), graph.nodeArray()[to]->getY());
-		int realWeight = (int)(sqrt((pow(end.x - start.x, 2)) + (pow(end.y - start.y, 2))));
-		graph.addArc(from, to, realWeight);
-	}
-	myfile.close();
-
-	//setting up the circles for the nodes
-	int size = 25;
-	sf::CircleShape circles[graphSize];
-	for (int i = 0; i < graphSize; i++) {
-		sf::CircleShape circle(size);
-		circle.setFillColor(sf::Color(0,0,155,255));
-		circle.setOrigin(size / 2, size / 2);
-		circle.setPosition(graph.nodeArray()[i]->getX(), graph.nodeArray()[i]->getY());
-		circles[i] = circle;
-	}
 	//setting up font for the drawing of info	
 	//load a font
 	sf::Font font;
 	font.loadFromFile("C:\\Windows\\Fonts\\GARA.TTF");
 
+	//the arcs, weights, nodes and names are built once and drawn in a few calls
+	GraphView<pair<string, int>, int> view(font);
+	view.build(graph);
+
+	if (benchFrames > 0) {
+		benchmark(view, graph, benchFrames);
+		delete pGraph;
+		return 0;
+	}
+
+	sf::RenderWindow window(sf::VideoMode(1280, 720, 32), "A* PathFinding");
+	window.setFramerateLimit(60);	
+
+	sf::Text startNode("", font, 30);
+	startNode.setColor(sf::Color(0,0,0));
+	startNode.setStyle(sf::Text::Bold);
+	startNode.setPosition(1060, 330);
+
+	sf::Text goalNode("", font, 30);
+	goalNode.setColor(sf::Color(0,0,0));
+	goalNode.setStyle(sf::Text::Bold);
+	goalNode.setPosition(1060, 420);
+
+	sf::Text pathCost("0", font, 30);
+	pathCost.setColor(sf::Color(0,0,0));
+	pathCost.setStyle(sf::Text::Bold);
+	pathCost.setPosition(1050, 510);
+	int shownCost = 0;
+
+	//the start and goal the last search ran for, so it only runs again when they change
+	string searchedStart = "";
+	string searchedGoal = "";
+
 	while (window.isOpen())
 	{
 		window.clear();
-		//drawing the arcs between the nodes
-		for (int i = 0; i < graphSize; i++) { 
-			list<Arc1>::const_iterator iter = graph.nodeArray()[i]->arcList().begin();
-			list<Arc1>::const_iterator endIter = graph.nodeArray()[i]->arcList().end();
-			for( ; iter != endIter; iter++ ) {
-				sf::Vector2f start = sf::Vector2f(graph.nodeArray()[i]->getX() + size / 2, graph.nodeArray()[i]->getY() + size / 2);
-				sf::Vector2f end = sf::Vector2f((*iter).node()->getX() + size / 2, (*iter).node()->getY() + size / 2);
-				sf::Vertex line[] =
-				{
-					sf::Vertex(start),
-					sf::Vertex(end)
-				};
-				window.draw(line, 2, sf::Lines);
-
-				sf::Text arcWeight(to_string((*iter).weight()), font, 20);
-				arcWeight.setColor(sf::Color::Magenta);
-				arcWeight.setPosition(start + sf::Vector2f((end - start).x / 2 - 20, (end - start).y / 2));
-				window.draw(arcWeight);
-			}
-		}
 
 		graph.checkMousePos(window);
 		graph.selectNodes(window);
 
-		//graph.drawNodes(window);
-		//COLOR 0 = NORMAL, 1 = YELLOW, 2 = RED, 3 = HIGHLIGHTED, 4 = SELECTED, 5= GOAL SELECTED
-		for (int i = 0; i < graphSize; i++) {
-			if (graph.nodeArray()[i]->getColor() == 0) {
-				circles[i].setFillColor(sf::Color(0,255,255));
-				circles[i].setOutlineThickness(4);
-				circles[i].setOutlineColor(sf::Color(0, 102, 0));
-			}
-			else if (graph.nodeArray()[i]->getColor() == 1) {
-				circles[i].setFillColor(sf::Color(240,230,140));
-				circles[i].setOutlineThickness(4);
-				circles[i].setOutlineColor(sf::Color(255, 0, 0));
-			}
-			else if (graph.nodeArray()[i]->getColor() == 2) {
-				circles[i].setFillColor(sf::Color(68, 243, 267));
-				circles[i].setOutlineThickness(4);
-				circles[i].setOutlineColor(sf::Color(0, 102, 0));
-			}
-			else if (graph.nodeArray()[i]->getColor() == 3) {
-				circles[i].setFillColor(sf::Color(240,230,140));
-				circles[i].setOutlineThickness(4);
-				circles[i].setOutlineColor(sf::Color(255, 0, 0));
-			}
-			else if (graph.nodeArray()[i]->getColor() == 4) {
-				circles[i].setFillColor(sf::Color(240,0,0));
-				circles[i].setOutlineThickness(4);
-				circles[i].setOutlineColor(sf::Color(240,230,140));
-			}
-			else if (graph.nodeArray()[i]->getColor() == 5) {
-				circles[i].setFillColor(sf::Color(240,230,140));
-				circles[i].setOutlineThickness(4);
-				circles[i].setOutlineColor(sf::Color(255, 0, 0));
-			}
-
-			window.draw(circles[i]);
-
-			//drawing the names of the nodes
-			sf::Text nodeName(graph.nodeArray()[i]->data().first, font, 30);
-			nodeName.setColor(sf::Color(0,0,0));
-			nodeName.setStyle(sf::Text::Bold);
-			nodeName.setPosition(graph.nodeArray()[i]->getX() + 4, graph.nodeArray()[i]->getY()- 10);
-			window.draw(nodeName);
-		}
-
 			//used to specify which nodes you are using as start and end
 		if (graph.startSelected() == false)
 			graph.selectNodes(window);
 		else if (graph.startSearch() == false)
 			graph.selectNodes(window);
 
-		int startIndex = 0;
-		int goalIndex = 0;
-		
-		if (graph.startSearch()) {
-
+		if (graph.startSearch() == false) {
+			searchedStart = "";
+			searchedGoal = "";
+		}
+		else if (graph.StartNode() != searchedStart || graph.GoalNode() != searchedGoal) {
+			int startIndex = 0;
+			int goalIndex = 0;
 			for (; startIndex < graph.size(); startIndex++) {
 				if (graph.StartNode() == graph.nodeArray()[startIndex]->data().first) {
 					break;
@@ -217,37 +200,40 @@ int main(int argc, char *argv[]) {
 					break;
 				}
 			}
-			graph.AStar(graph.nodeArray()[startIndex], graph.nodeArray()[goalIndex], path);	
+			if (startIndex < graph.size() && goalIndex < graph.size())
+				graph.AStar(graph.nodeArray()[startIndex], graph.nodeArray()[goalIndex], path);	
+			searchedStart = graph.StartNode();
+			searchedGoal = graph.GoalNode();
 		}
 
+		//only the nodes whose colour changed are restyled
+		view.update(graph);
+		view.draw(window);
+
 		graph.drawNodeInfo(window);
 
 		window.draw(resetButton);
 		window.draw(title);
 		window.draw(info);
 
-		sf::Text startNode(graph.StartNode(), font, 30);
-		startNode.setColor(sf::Color(0,0,0));
-		startNode.setStyle(sf::Text::Bold);
-		startNode.setPosition(1060, 330);
+		if (startNode.getString() != graph.StartNode())
+			startNode.setString(graph.StartNode());
 		window.draw(startNode);
 
-		sf::Text goalNode(graph.GoalNode(), font, 30);
-		goalNode.setColor(sf::Color(0,0,0));
-		goalNode.setStyle(sf::Text::Bold);
-		goalNode.setPosition(1060, 420);
+		if (goalNode.getString() != graph.GoalNode())
+			goalNode.setString(graph.GoalNode());
 		window.draw(goalNode);
 
-		sf::Text pathCost(to_string(graph.PathCost()), font, 30);
-		pathCost.setColor(sf::Color(0,0,0));
-		pathCost.setStyle(sf::Text::Bold);
-		pathCost.setPosition(1050, 510);
+		if (shownCost != graph.PathCost()) {
+			shownCost = graph.PathCost();
+			pathCost.setString(to_string(shownCost));
+		}
 		window.draw(pathCost);
 
 		window.display();
 	}
 
-
+	delete pGraph;
 	system("PAUSE");
 }
 
@@ -0,0 +1,185 @@
+#ifndef SPATIALINDEX_H
+#define SPATIALINDEX_H
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+
+// ----------------------------------------------------------------
+//  Name:           SpatialIndex
+//  Description:    A k-d tree over node positions, for snapping a
+//                  point to the nearest node and for radius and box
+//                  queries. The tree is stored implicitly in one
+//                  array: the median of each range is its root, with
+//                  the halves either side split on the other axis.
+// ----------------------------------------------------------------
+class SpatialIndex {
+private:
+	struct Point {
+		int x;
+		int y;
+		int index;
+	};
+
+	vector<Point> m_points;
+
+	static double squaredDistance( const Point& point, double x, double y ) {
+		double dx = point.x - x;
+		double dy = point.y - y;
+		return dx * dx + dy * dy;
+	}
+
+	// ----------------------------------------------------------------
+	//  Description:    Sorts [begin, end) into a k-d tree, splitting
+	//                  on x at even depths and y at odd ones.
+	// ----------------------------------------------------------------
+	void split( int begin, int end, int depth ) {
+		if( end - begin <= 1 ) {
+			return;
+		}
+		int middle = begin + (end - begin) / 2;
+		if( depth % 2 == 0 ) {
+			nth_element( m_points.begin() + begin, m_points.begin() + middle, m_points.begin() + end, []( const Point& a, const Point& b ) {
+				return a.x < b.x;
+			} );
+		}
+		else {
+			nth_element( m_points.begin() + begin, m_points.begin() + middle, m_points.begin() + end, []( const Point& a, const Point& b ) {
+				return a.y < b.y;
+			} );
+		}
+		split( begin, middle, depth + 1 );
+		split( middle + 1, end, depth + 1 );
+	}
+
+	void nearest( int begin, int end, int depth, double x, double y, int& best, double& bestDistance ) const {
+		if( begin >= end ) {
+			return;
+		}
+		int middle = begin + (end - begin) / 2;
+		const Point& point = m_points[middle];
+		double distance = squaredDistance( point, x, y );
+		if( distance < bestDistance ) {
+			bestDistance = distance;
+			best = point.index;
+		}
+
+		// search the side the point is on first, then the other side
+		// only if the splitting line is closer than the best so far.
+		double offset = depth % 2 == 0 ? x - point.x : y - point.y;
+		if( offset < 0 ) {
+			nearest( begin, middle, depth + 1, x, y, best, bestDistance );
+			if( offset * offset < bestDistance ) {
+				nearest( middle + 1, end, depth + 1, x, y, best, bestDistance );
+			}
+		}
+		else {
+			nearest( middle + 1, end, depth + 1, x, y, best, bestDistance );
+			if( offset * offset < bestDistance ) {
+				nearest( begin, middle, depth + 1, x, y, best, bestDistance );
+			}
+		}
+	}
+
+	// collects the positions in m_points of the points inside a box.
+	void withinBox( int begin, int end, int depth, double minX, double minY, double maxX, double maxY, vector<int>& found ) const {
+		if( begin >= end ) {
+			return;
+		}
+		int middle = begin + (end - begin) / 2;
+		const Point& point = m_points[middle];
+		if( point.x >= minX && point.x <= maxX && point.y >= minY && point.y <= maxY ) {
+			found.push_back( middle );
+		}
+
+		int line = depth % 2 == 0 ? point.x : point.y;
+		double low = depth % 2 == 0 ? minX : minY;
+		double high = depth % 2 == 0 ? maxX : maxY;
+		if( low <= line ) {
+			withinBox( begin, middle, depth + 1, minX, minY, maxX, maxY, found );
+		}
+		if( high >= line ) {
+			withinBox( middle + 1, end, depth + 1, minX, minY, maxX, maxY, found );
+		}
+	}
+
+public:
+	// ----------------------------------------------------------------
+	//  Name:           build
+	//  Description:    Builds the tree from every node in a graph.
+	//  Arguments:      The graph.
+	//  Return Value:   None.
+	// ----------------------------------------------------------------
+	template<class GraphType>
+	void build( GraphType& graph ) {
+		m_points.clear();
+		for( int i = 0; i < graph.maxSize(); i++ ) {
+			if( graph.nodeArray()[i] != 0 ) {
+				Point point = { graph.nodeArray()[i]->getX(), graph.nodeArray()[i]->getY(), i };
+				m_points.push_back( point );
+			}
+		}
+		split( 0, (int)m_points.size(), 0 );
+	}
+
+	// ----------------------------------------------------------------
+	//  Name:           nearest
+	//  Description:    Finds the node closest to a point.
+	//  Arguments:      The first and second parameters are the point.
+	//                  The third parameter limits how far away the node
+	//                  may be (exclusive).
+	//  Return Value:   The node index, or -1 if none is close enough.
+	// ----------------------------------------------------------------
+	int nearest( double x, double y, double maxDistance = numeric_limits<double>::max() ) const {
+		int best = -1;
+		double bestDistance = maxDistance < 1e150 ? maxDistance * maxDistance : numeric_limits<double>::max();
+		nearest( 0, (int)m_points.size(), 0, x, y, best, bestDistance );
+		return best;
+	}
+
+	// ----------------------------------------------------------------
+	//  Name:           withinRadius
+	//  Description:    Finds every node within a distance of a point.
+	//  Arguments:      The first and second parameters are the point.
+	//                  The third parameter is the radius (inclusive).
+	//                  The fourth parameter is filled with the indices.
+	//  Return Value:   None.
+	// ----------------------------------------------------------------
+	void withinRadius( double x, double y, double radius, vector<int>& found ) const {
+		found.clear();
+		withinBox( 0, (int)m_points.size(), 0, x - radius, y - radius, x + radius, y + radius, found );
+		// trim the corners of the box down to the circle.
+		size_t kept = 0;
+		for( size_t i = 0; i < found.size(); i++ ) {
+			const Point& point = m_points[found[i]];
+			if( squaredDistance( point, x, y ) <= radius * radius ) {
+				found[kept++] = point.index;
+			}
+		}
+		found.resize( kept );
+	}
+
+	// ----------------------------------------------------------------
+	//  Name:           withinBox
+	//  Description:    Finds every node inside a rectangle.
+	//  Arguments:      The first two parameters are the top left corner.
+	//                  The next two parameters are the bottom right.
+	//                  The fifth parameter is filled with the indices.
+	//  Return Value:   None.
+	// ----------------------------------------------------------------
+	void withinBox( double minX, double minY, double maxX, double maxY, vector<int>& found ) const {
+		found.clear();
+		withinBox( 0, (int)m_points.size(), 0, minX, minY, maxX, maxY, found );
+		for( size_t i = 0; i < found.size(); i++ ) {
+			found[i] = m_points[found[i]].index;
+		}
+	}
+
+	int size() const {
+		return (int)m_points.size();
+	}
+};
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef WORKERTEAM_H
+#define WORKERTEAM_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+using namespace std;
+
+// ----------------------------------------------------------------
+//  Name:           WorkerTeam
+//  Description:    A fixed team of threads for algorithms that run in
+//                  many short parallel phases, such as one per bucket
+//                  or level. The threads are started once and wait
+//                  between phases, so a phase costs a wake-up rather
+//                  than a thread start. The calling thread is member 0
+//                  and works too.
+// ----------------------------------------------------------------
+class WorkerTeam {
+private:
+	vector<thread> m_threads;
+	mutex m_lock;
+	condition_variable m_start;
+	condition_variable m_done;
+
+	// the current phase's work, its number and the members still at it.
+	function<void ( int )> m_work;
+	unsigned long long m_phase;
+	int m_busy;
+	bool m_stopping;
+
+	// not copyable.
+	WorkerTeam( const WorkerTeam& );
+	WorkerTeam& operator=( const WorkerTeam& );
+
+	void work( int member );
+
+public:
+	WorkerTeam( int size = 0 );
+	~WorkerTeam();
+
+	void run( const function<void ( int )>& work );
+
+	// the number of members, counting the calling thread.
+	int size() const {
+		return (int)m_threads.size() + 1;
+	}
+};
+
+// ----------------------------------------------------------------
+//  Name:           WorkerTeam
+//  Description:    Constructor, starts the threads.
+//  Arguments:      The number of members, 0 for one per core.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+inline WorkerTeam::WorkerTeam( int size ) : m_phase( 0 ), m_busy( 0 ), m_stopping( false ) {
+	if( size <= 0 ) {
+		size = (int)thread::hardware_concurrency();
+		if( size <= 0 ) {
+			size = 1;
+		}
+	}
+	for( int i = 1; i < size; i++ ) {
+		m_threads.push_back( thread( &WorkerTeam::work, this, i ) );
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           ~WorkerTeam
+//  Description:    Destructor, stops the threads.
+//  Arguments:      None.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+inline WorkerTeam::~WorkerTeam() {
+	{
+		lock_guard<mutex> guard( m_lock );
+		m_stopping = true;
+	}
+	m_start.notify_all();
+	for( size_t i = 0; i < m_threads.size(); i++ ) {
+		m_threads[i].join();
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           work
+//  Description:    A member's loop: waits for each phase, runs its
+//                  share and reports back.
+//  Arguments:      The member's number.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+inline void WorkerTeam::work( int member ) {
+	unsigned long long done = 0;
+	unique_lock<mutex> guard( m_lock );
+	for( ;; ) {
+		m_start.wait( guard, [this, done]() {
+			return m_stopping == true || m_phase != done;
+		} );
+		if( m_stopping == true ) {
+			return;
+		}
+		done = m_phase;
+		guard.unlock();
+		m_work( member );
+		guard.lock();
+		if( --m_busy == 0 ) {
+			m_done.notify_one();
+		}
+	}
+}
+
+// ----------------------------------------------------------------
+//  Name:           run
+//  Description:    Runs one phase: calls the work on every member at
+//                  once and returns when all of them have finished.
+//                  Everything written in the phase is visible to the
+//                  caller afterwards.
+//  Arguments:      The work, called with the member's number, from 0
+//                  up to size() - 1.
+//  Return Value:   None.
+// ----------------------------------------------------------------
+inline void WorkerTeam::run( const function<void ( int )>& work ) {
+	if( m_threads.size() == 0 ) {
+		work( 0 );
+		return;
+	}
+	{
+		lock_guard<mutex> guard( m_lock );
+		m_work = work;
+		m_busy = (int)m_threads.size();
+		m_phase++;
+	}
+	m_start.notify_all();
+	work( 0 );
+
+	unique_lock<mutex> guard( m_lock );
+	m_done.wait( guard, [this]() {
+		return m_busy == 0;
+	} );
+}
+
+#endif